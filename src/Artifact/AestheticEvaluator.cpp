@@ -6,75 +6,59 @@ void AestheticEvaluator::setup(uint32_t width, uint32_t height)
 	_compressor.setup(_pcBlockSize);
 	_compressor.setWriteImageToDisk(_bWriteToDisk);
 	_compressor.setWriteEncodingToDisk(_bWriteEncodingToDisk);
+	_compressor.setDomainSearch(_domainSearch, _searchFallbackError);
+	_jpegComplexity.setup(_jpegQuality);
 }
 
 std::vector<double> AestheticEvaluator::evaluate(cv::Mat im)
 {
-	cv::Mat srcIm;
+	_context.reset(im);
+	return evaluate(_context);
+}
+
+std::vector<double> AestheticEvaluator::evaluate(FeatureContext& context)
+{
+	const cv::Mat& im = context.getImage();
 	if (im.elemSize() != 1) {
 		ofLog() << "[Evaluator] Warning: elemSize of im is not equal to 1.";
 	}
-	if (im.total() != _processingSize.area()) {
-		cv::resize(im, srcIm, cv::Size(_processingSize));
-	}
-	else {
-		srcIm = im;
-	}
+	FeatureContext& src = _bNativeResolution ?
+		context.getRegion(cv::Rect(0, 0, im.cols - im.cols % _pcBlockSize, im.rows - im.rows % _pcBlockSize)) :
+		context.getResized(_processingSize);
+	const cv::Mat& srcIm = src.getImage();
 
 	cv::Mat diff;
 	cv::Mat diffConverted;
 	cv::Mat se(srcIm.rows, srcIm.cols, CV_64FC1);
-	cv::Mat se_jpeg(srcIm.rows, srcIm.cols, CV_64FC1);
 
 	// Coverage measure
-	double coverage = cv::mean(srcIm)[0] / 255.0;
+	double coverage = src.getCoverage();
 	double coverageReward = coverageFunc(coverage);
 
 
 	// Image Complexity -- JPEG Sobel method
+	const cv::Mat& grad = src.getGradient();
 
-	cv::Mat grad, grad_x, grad_y;
-	cv::Mat abs_grad_x, abs_grad_y;
-
-	cv::Sobel(srcIm, grad_x, CV_16S, 1, 0, 1);
-	cv::Sobel(srcIm, grad_y, CV_16S, 0, 1, 1);
-	cv::convertScaleAbs(grad_x, abs_grad_x);
-	cv::convertScaleAbs(grad_y, abs_grad_y);
-	cv::addWeighted(abs_grad_x, 0.5, abs_grad_y, 0.5, 0, grad);
-
-	ofPixels sobelPixBuffer;
-	sobelPixBuffer.setFromExternalPixels(grad.ptr(), grad.rows, grad.cols, ofPixelFormat::OF_PIXELS_GRAY);
-
-	ofImageLoadSettings settings;
-	settings.grayscale = true;
+	// Compressed size and decoding error of the gradient image in a single pass, the decoded image is only needed on disk
+	JpegComplexity::Result jpeg = _jpegComplexity.estimate(grad, _bWriteToDisk ? &_jpegDecoded : nullptr);
 
-	ofPixels jpegPixBuffer;
-	ofBuffer jpegBuffer;
-	ofSaveImage(sobelPixBuffer, jpegBuffer, ofImageFormat::OF_IMAGE_FORMAT_JPEG, ofImageQualityType::OF_IMAGE_QUALITY_HIGH);
-	ofLoadImage(jpegPixBuffer, jpegBuffer, settings);
-
-	cv::Mat jpegMat(grad.rows, grad.cols, CV_8UC1, jpegPixBuffer.getData());
-
-	cv::absdiff(grad, jpegMat, diff);
-	diff.convertTo(diffConverted, CV_64F);
-
-	cv::pow(diffConverted, 2, se_jpeg);
-	double rmseIC = sqrt(cv::mean(se_jpeg)[0]);
-	double compressionRatioIC = (double)srcIm.total() / jpegBuffer.size();
+	double rmseIC = jpeg.rmse;
+	double compressionRatioIC = (double)srcIm.total() / jpeg.bytes;
 	double IC = rmseIC / compressionRatioIC;
 
 
 	// Processing Complexity -- Fractal method
 
 	// Lower contrast to improve the reliability of the fractal compression algorithm (alpha[1.0-3.0], beta[0-100])
-	cv::Mat pcImage, pcBlur;
-	cv::blur(srcIm, pcBlur, cv::Size(3, 3));
-	pcBlur.convertTo(pcImage, CV_8UC1, 0.9, 20.0);
+	cv::Mat pcImage;
+	src.getBlur(3).convertTo(pcImage, CV_8UC1, 0.9, 20.0);
 
 	_compressor.allocate(pcImage);
 	size_t encodingSize = _compressor.getEncodingBytes();
 
+	uint64_t encodeStart = ofGetElapsedTimeMicros();
 	_compressor.encode();
+	uint64_t encodeMicros = ofGetElapsedTimeMicros() - encodeStart;
 	_compressor.decode(_decodingDepth - _decodingLevelDiff);
 	cv::Mat fractalMat_t0 = _compressor.getDecodedImage();
 
@@ -85,7 +69,9 @@ std::vector<double> AestheticEvaluator::evaluate(cv::Mat im)
 	cv::absdiff(pcImage, fractalMat_t0, diff);
 	diff.convertTo(diffConverted, CV_64FC1);
 	cv::pow(diffConverted, 2, se);
-	cv::imwrite("data/keep/eval_out_se_pct0.bmp", se);
+	if (_bWriteToDisk) {
+		cv::imwrite("data/keep/eval_out_se_pct0.bmp", se);
+	}
 
 	double rmsePCt0 = sqrt(cv::mean(se)[0]);
 	double PCt0 = glm::max(1.0/rmsePCt0, _pcLowerBound);
@@ -94,7 +80,9 @@ std::vector<double> AestheticEvaluator::evaluate(cv::Mat im)
 	cv::absdiff(pcImage, fractalMat_t1, diff);
 	diff.convertTo(diffConverted, CV_64FC1);
 	cv::pow(diffConverted, 2, se);
-	cv::imwrite("data/keep/eval_out_se_pct1.bmp", se);
+	if (_bWriteToDisk) {
+		cv::imwrite("data/keep/eval_out_se_pct1.bmp", se);
+	}
 
 	double rmsePCt1 = sqrt(cv::mean(se)[0]);
 	double PCt1 = glm::max(1.0/rmsePCt1, _pcLowerBound);
@@ -136,19 +124,36 @@ std::vector<double> AestheticEvaluator::evaluate(cv::Mat im)
 	// Make aesthetic reward partly proportional to the coverage reward to prevent high rewards for low coverage artifacts
 	double fitness = coverageReward * 100.0 + (aestheticReward * coverageReward) * !bDiscard;
 
-	char msg[512];
+	// Domain search trade-off: share of the exhaustive comparisons, blocks that fell back and the resulting block error
+	const FractalCompressor::SearchStats& searchStats = _compressor.getSearchStats();
+	uint64_t blockError = 0;
+	for (int i = 0; i < _compressor.getNumBlocks(); i++) {
+		blockError += _compressor.getEncodingResultPtr()[i].error;
+	}
+
+	char msg[768];
 	sprintf(msg,
-		"\nEvaluation Report:\ncoverage: %.4f%% -> %.4f\nIC (Sobel/JPEG): %.4f; PC: %.4f; PCdiff: %.4f\nPCt0: %.4f; PCt1: %.4f;\naestheticReward:%.4f\nfitness: %.4f",
+		"\nEvaluation Report:\ncoverage: %.4f%% -> %.4f\nIC (Sobel/JPEG): %.4f; PC: %.4f; PCdiff: %.4f\nPCt0: %.4f; PCt1: %.4f;\nPC search (%s, %dx%d): %.2fms; compared: %.1f%%; fallbacks: %d/%d; block error: %.2f\naestheticReward:%.4f\nfitness: %.4f",
 		coverage*100.0, coverageReward,
 		IC, PC, PCdiffRaw,
 		PCt0, PCt1,
+		(_domainSearch == FractalCompressor::SEARCH_CLASSIFIED) ? "classified" : "exhaustive", srcIm.cols, srcIm.rows,
+		encodeMicros / 1000.0,
+		searchStats.candidates * 100.0 / std::max(searchStats.exhaustiveCandidates, uint64_t(1)),
+		searchStats.fallbacks, _compressor.getNumBlocks(),
+		blockError / double(std::max(int(srcIm.total()), 1)),
 		aestheticReward, 
 		fitness
 	);
 	ofLog() << msg << std::endl;
 
 	if (_bWriteToDisk) {
-		cv::imwrite("data/keep/eval_out_jpeg.bmp", jpegMat);
+		cv::Mat se_jpeg;
+		cv::absdiff(grad, _jpegDecoded, diff);
+		diff.convertTo(diffConverted, CV_64F);
+		cv::pow(diffConverted, 2, se_jpeg);
+
+		cv::imwrite("data/keep/eval_out_jpeg.bmp", _jpegDecoded);
 		cv::imwrite("data/keep/eval_out_se_jpeg.bmp", se_jpeg);
 		cv::imwrite("data/keep/eval_out_lvl1.bmp", fractalMat_t0);
 		cv::imwrite("data/keep/eval_out_lvl2.bmp", fractalMat_t1);
@@ -180,7 +185,28 @@ double AestheticEvaluator::coverageFunc(double coverage)
 	return std::min(std::max(y, 0.0), 1.0);
 }
 
+void AestheticEvaluator::setNumThreads(uint32_t numThreads)
+{
+	_compressor.setNumThreads(numThreads);
+}
+
 void AestheticEvaluator::setDecodingDepth(int depth)
 {
 	_decodingDepth = depth;
 }
+
+void AestheticEvaluator::setWriteToDisk(bool enable)
+{
+	_bWriteToDisk = enable;
+}
+
+void AestheticEvaluator::setDomainSearch(FractalCompressor::DomainSearch search, float fallbackError)
+{
+	_domainSearch = search;
+	_searchFallbackError = fallbackError;
+}
+
+void AestheticEvaluator::setNativeResolution(bool enable)
+{
+	_bNativeResolution = enable;
+}
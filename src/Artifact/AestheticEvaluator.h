@@ -1,6 +1,7 @@
 #pragma once
 #include "Artifact/EvaluatorBase.h"
 #include "Artifact/FractalCompressor/FractalCompressor.h"
+#include "Artifact/JpegComplexity.h"
 #include "ofxOpenCv.h"
 
 class AestheticEvaluator : public EvaluatorBase
@@ -8,22 +9,49 @@ class AestheticEvaluator : public EvaluatorBase
 public:
 	virtual void setup(uint32_t width, uint32_t height) override;
 	virtual std::vector<double> evaluate(cv::Mat im) override;
+	virtual std::vector<double> evaluate(FeatureContext& context) override;
+	virtual void setNumThreads(uint32_t numThreads) override;
 
 	void setDecodingDepth(int depth);
 
+	// Intermediate images of every evaluation go to data/keep/ under fixed names, so only one evaluator may write them.
+	// Applied on setup
+	void setWriteToDisk(bool enable);
+
+	// Classified domain search of the fractal encode, blocks with a mean absolute error above fallbackError are
+	// searched exhaustively again (see FractalCompressor::setDomainSearch). Applied on setup
+	void setDomainSearch(FractalCompressor::DomainSearch search, float fallbackError);
+
+	// Evaluates at the resolution of the artifact instead of a fixed processing size
+	void setNativeResolution(bool enable);
+
 private:
 
 	// Remaps coverage to a biased curve [0..1]
 	double coverageFunc(double coverage);
 
 	FractalCompressor _compressor;
+	JpegComplexity _jpegComplexity;
+
+	// Intermediates of standalone evaluations, buffers are reused across evaluations
+	FeatureContext _context;
+	cv::Mat _jpegDecoded;
 
 	cv::Size _processingSize = cv::Size(256, 256);
 
+	// Evaluate at the resolution of the artifact instead of _processingSize, cropped to a multiple of the block size.
+	// Encoding time grows with the square of the number of blocks, so pair this with the classified domain search
+	bool _bNativeResolution = false;
+
+	FractalCompressor::DomainSearch _domainSearch = FractalCompressor::SEARCH_EXHAUSTIVE;
+	float _searchFallbackError = 6.0f;
+
 	int _pcBlockSize = 8;
 	int _decodingDepth = 4;
 	int _decodingLevelDiff = 2;
 
+	int _jpegQuality = 75;	// OF_IMAGE_QUALITY_HIGH
+
 	double _peakCoverage = 0.06125;
 
 	// Aesthetic Fitness Terms (Normal: _a=1.0; High Complexity: _a=1.5)
@@ -33,6 +61,6 @@ private:
 
 	double _pcLowerBound = 0.0001;
 
-	bool _bWriteToDisk = true;
+	bool _bWriteToDisk = false;
 	bool _bWriteEncodingToDisk = false;
 };
@@ -0,0 +1,64 @@
+#include "CompositeEvaluator.h"
+
+void CompositeEvaluator::add(std::unique_ptr<EvaluatorBase> evaluator, double weight)
+{
+	_evaluators.push_back(std::move(evaluator));
+	_weights.push_back(weight);
+	_resultOffsets.push_back(0);
+}
+
+void CompositeEvaluator::setup(uint32_t width, uint32_t height)
+{
+	for (auto& evaluator : _evaluators) {
+		evaluator->setup(width, height);
+	}
+}
+
+std::vector<double> CompositeEvaluator::evaluate(cv::Mat im)
+{
+	if (im.elemSize() != 1) {
+		ofLog() << "[Evaluator] Warning: elemSize of im is not equal to 1.";
+	}
+	_context.reset(im);
+	return evaluate(_context);
+}
+
+std::vector<double> CompositeEvaluator::evaluate(FeatureContext& context)
+{
+	std::vector<double> results(1, 0.0);
+
+	for (size_t i = 0; i < _evaluators.size(); i++) {
+		std::vector<double> evaluatorResults = _evaluators[i]->evaluate(context);
+
+		_resultOffsets[i] = results.size();
+		if (!evaluatorResults.empty()) {
+			results[0] += _weights[i] * evaluatorResults[0];
+			results.insert(results.end(), evaluatorResults.begin(), evaluatorResults.end());
+		}
+	}
+
+	char msg[256];
+	sprintf(msg, "Composite Evaluation Report:\nfitness: %f; objectives: %d; features computed: %d; reused: %d\n",
+		results[0], int(_evaluators.size()), context.getNumComputed(), context.getNumReused()
+	);
+	ofLog() << msg;
+
+	return results;
+}
+
+void CompositeEvaluator::setNumThreads(uint32_t numThreads)
+{
+	for (auto& evaluator : _evaluators) {
+		evaluator->setNumThreads(numThreads);
+	}
+}
+
+size_t CompositeEvaluator::getNumEvaluators() const
+{
+	return _evaluators.size();
+}
+
+size_t CompositeEvaluator::getResultOffset(size_t evaluator) const
+{
+	return _resultOffsets[evaluator];
+}
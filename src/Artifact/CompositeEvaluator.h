@@ -0,0 +1,32 @@
+#pragma once
+#include "Artifact/EvaluatorBase.h"
+#include "ofxOpenCv.h"
+
+// Scores an artifact on several objectives at once. Every evaluator reads from the same feature context, so
+// intermediates like coverage, blurs and gradients are computed once per artifact no matter how many objectives use
+// them.
+//
+// Results: [fitness, results of the first evaluator..., results of the second evaluator..., ...]
+//   fitness: weighted sum of the fitness (first result) of every evaluator
+class CompositeEvaluator : public EvaluatorBase
+{
+public:
+	void add(std::unique_ptr<EvaluatorBase> evaluator, double weight = 1.0);
+
+	virtual void setup(uint32_t width, uint32_t height) override;
+	virtual std::vector<double> evaluate(cv::Mat im) override;
+	virtual std::vector<double> evaluate(FeatureContext& context) override;
+	virtual void setNumThreads(uint32_t numThreads) override;
+
+	size_t getNumEvaluators() const;
+
+	// Index of the first result of an evaluator in the results of the last evaluation
+	size_t getResultOffset(size_t evaluator) const;
+
+private:
+	std::vector<std::unique_ptr<EvaluatorBase>> _evaluators;
+	std::vector<double> _weights;
+	std::vector<size_t> _resultOffsets;
+
+	FeatureContext _context;
+};
@@ -3,75 +3,218 @@
 
 EvaluationDispatcher::EvaluationDispatcher() { }
 
-void EvaluationDispatcher::setup(EvaluationType type, uint32_t width, uint32_t height)
+std::unique_ptr<EvaluatorBase> EvaluationDispatcher::createEvaluator(EvaluationType type, const EvaluatorSettings& settings)
 {
-	if (type == Coverage) _evaluator = std::make_unique<CoverageEvaluator>();
-	else if (type == CircleCoverage) _evaluator = std::make_unique<CircleCoverageEvaluator>();
-	else if (type == InverseCircleCoverage) _evaluator = std::make_unique<InverseCircleCoverageEvaluator>();
-	else if (type == OrderlyCoverage) _evaluator = std::make_unique<OrderlyCoverageEvaluator>();
-	else if (type == Aesthetics) _evaluator = std::make_unique<AestheticEvaluator>();
-	else _evaluator = std::make_unique<CoverageEvaluator>();
+	if (type == Coverage) return std::make_unique<CoverageEvaluator>();
+	else if (type == CircleCoverage) return std::make_unique<CircleCoverageEvaluator>();
+	else if (type == InverseCircleCoverage) return std::make_unique<InverseCircleCoverageEvaluator>();
+	else if (type == MaskCoverage) return std::make_unique<MaskCoverageEvaluator>(settings.maskFile);
+	else if (type == OrderlyCoverage) {
+		std::unique_ptr<OrderlyCoverageEvaluator> orderly = std::make_unique<OrderlyCoverageEvaluator>();
+		orderly->setWriteToDisk(settings.bWriteToDisk);
+		return orderly;
+	}
+	else if (type == Aesthetics) {
+		std::unique_ptr<AestheticEvaluator> aesthetic = std::make_unique<AestheticEvaluator>();
+		aesthetic->setWriteToDisk(settings.bWriteToDisk);
+		aesthetic->setDomainSearch(settings.domainSearch, settings.searchFallbackError);
+		aesthetic->setNativeResolution(settings.bNativeResolution);
+		return aesthetic;
+	}
+	else if (type == Composite) {
+		std::unique_ptr<CompositeEvaluator> composite = std::make_unique<CompositeEvaluator>();
+		for (size_t i = 0; i < settings.compositeTypes.size(); i++) {
+			if (settings.compositeTypes[i] == Composite) {
+				continue;
+			}
+			double weight = (i < settings.compositeWeights.size()) ? settings.compositeWeights[i] : 1.0;
+			composite->add(createEvaluator(settings.compositeTypes[i], settings), weight);
+		}
+		return composite;
+	}
+	else return std::make_unique<CoverageEvaluator>();
+}
+
+void EvaluationDispatcher::setup(EvaluationType type, uint32_t width, uint32_t height, uint32_t numWorkers, uint32_t numWorkerThreads, const EvaluatorSettings& evaluatorSettings)
+{
+	if (numWorkers == 0) {
+		numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	if (numWorkerThreads == 0) {
+		numWorkerThreads = std::max(std::thread::hardware_concurrency() / numWorkers, 1u);
+	}
 
-	_evaluator->setup(width, height);
+	for (uint32_t i = 0; i < numWorkers; i++) {
+		// The debug images have fixed names, workers writing them at once would leave a mix of evaluations
+		EvaluatorSettings workerSettings = evaluatorSettings;
+		workerSettings.bWriteToDisk = evaluatorSettings.bWriteToDisk && i == 0;
+
+		std::unique_ptr<EvaluatorBase> evaluator = createEvaluator(type, workerSettings);
+		evaluator->setup(width, height);
+		evaluator->setNumThreads(numWorkerThreads);
+		_workers.push_back(std::make_unique<Worker>(this, std::move(evaluator)));
+	}
+	for (auto& worker : _workers) {
+		worker->startThread();
+	}
 
 	ofAddListener(ofEvents().update, this, &EvaluationDispatcher::update);
-	startThread();
 	bSetup = true;
 }
 
+void EvaluationDispatcher::setupCache(size_t capacity, FitnessCache::Eviction eviction)
+{
+	_fitnessCache.setup(capacity, eviction);
+	_numMerged = 0;
+}
+
 void EvaluationDispatcher::queue(cv::Mat image, int generation, int id, bool report)
 {
 	ArtifactEntry entry{image};
 	entry.generation = generation;
 	entry.id = id;
 	entry.report = report;
+	entry.sequence = _nextSequence++;
+
+	if (_fitnessCache.isEnabled()) {
+		entry.key = FitnessCache::hash(image);
+
+		// The first of a set of identical artifacts is evaluated, the others wait for its results
+		auto pending = _pendingKeys.find(entry.key);
+		if (pending != _pendingKeys.end()) {
+			entry.image = cv::Mat();
+			pending->second.push_back(entry);
+			_numMerged++;
+			ofLog() << "Queued " << generation << ":" << id << " behind an identical artifact";
+			return;
+		}
+		if (_fitnessCache.lookup(entry.key, entry.results)) {
+			entry.image = cv::Mat();
+			_completed.emplace(entry.sequence, std::move(entry));
+			ofLog() << "Found " << generation << ":" << id << " in the fitness cache";
+			return;
+		}
+		_pendingKeys.emplace(entry.key, std::vector<ArtifactEntry>());
+	}
 
 	ofLog() << "Queued " << generation << ":" << id << " for evaluation";
 	_evalQueue.send(entry);
 }
 
+void EvaluationDispatcher::queueResults(const std::vector<double>& results, int generation, int id, bool report)
+{
+	ArtifactEntry entry;
+	entry.results = results;
+	entry.generation = generation;
+	entry.id = id;
+	entry.report = report;
+	entry.sequence = _nextSequence++;
+
+	_completed.emplace(entry.sequence, std::move(entry));
+	ofLog() << "Queued " << generation << ":" << id << " with known results";
+}
+
 void EvaluationDispatcher::queueResponse()
 {
-	ArtifactEntry entry{};
-	entry.response = 1;
-	_evalQueue.send(entry);
+	// Only waits for the artifacts queued so far
+	_responseBarriers.push_back(_nextSequence);
 }
 
-void EvaluationDispatcher::threadedFunction() 
+EvaluationDispatcher::Worker::Worker(EvaluationDispatcher* dispatcher, std::unique_ptr<EvaluatorBase> evaluator) :
+	_dispatcher(dispatcher), _evaluator(std::move(evaluator)) 
+{}
+
+void EvaluationDispatcher::Worker::threadedFunction()
 {
 	ArtifactEntry entry;
-	while (_evalQueue.receive(entry)) {
-		if (entry.response != 1) {
-			std::vector<double> results = _evaluator->evaluate(entry.image);
-			entry.results = results;
-		}
-		_updateQueue.send(entry);
+	while (_dispatcher->_evalQueue.receive(entry)) {
+		entry.results = _evaluator->evaluate(entry.image);
+		_dispatcher->_updateQueue.send(entry);
 	}
 }
 
 void EvaluationDispatcher::update(ofEventArgs& a) 
 {
 	ArtifactEntry entry;
-	if (_updateQueue.tryReceive(entry)) {
-		if (entry.response != 1) {
-			ofLog() << "Finished evaluating " << entry.generation << ":" << entry.id << "  f:" << entry.results[0];
-			if (entry.report) {
-				_fitnessQueue.push_back(entry.results);
+	while (_updateQueue.tryReceive(entry)) {
+		if (_fitnessCache.isEnabled()) {
+			_fitnessCache.insert(entry.key, entry.results);
+
+			auto pending = _pendingKeys.find(entry.key);
+			if (pending != _pendingKeys.end()) {
+				for (ArtifactEntry& duplicate : pending->second) {
+					duplicate.results = entry.results;
+					_completed.emplace(duplicate.sequence, std::move(duplicate));
+				}
+				_pendingKeys.erase(pending);
 			}
 		}
-		else {
-			onFitnessResponseReady.notify(_fitnessQueue);
-			_fitnessQueue.clear();
+		_completed.emplace(entry.sequence, std::move(entry));
+	}
+
+	// Workers finish out of order, hold results back until their predecessors are done
+	for (auto it = _completed.begin(); it != _completed.end() && it->first == _nextDelivery; it = _completed.erase(it)) {
+		deliver(it->second);
+		_nextDelivery++;
+	}
+
+	while (!_responseBarriers.empty() && _responseBarriers.front() <= _nextDelivery) {
+		std::stable_sort(_fitnessQueue.begin(), _fitnessQueue.end(), [](const ArtifactEntry& a, const ArtifactEntry& b) {
+			return (a.generation != b.generation) ? a.generation < b.generation : a.id < b.id;
+		});
+
+		std::vector<std::vector<double>> fitness;
+		fitness.reserve(_fitnessQueue.size());
+		for (const ArtifactEntry& e : _fitnessQueue) {
+			fitness.push_back(e.results);
 		}
+		onFitnessResponseReady.notify(fitness);
+
+		_fitnessQueue.clear();
+		_responseBarriers.pop_front();
+	}
+}
+
+void EvaluationDispatcher::deliver(const ArtifactEntry& entry)
+{
+	ofLog() << "Finished evaluating " << entry.generation << ":" << entry.id << "  f:" << entry.results[0];
+	if (entry.report) {
+		ArtifactEntry result;
+		result.generation = entry.generation;
+		result.id = entry.id;
+		result.results = entry.results;
+		_fitnessQueue.push_back(result);
 	}
 }
 
+uint32_t EvaluationDispatcher::getNumWorkers()
+{
+	return _workers.size();
+}
+
+uint32_t EvaluationDispatcher::getNumInFlight()
+{
+	return _nextSequence - _nextDelivery;
+}
+
+const FitnessCache& EvaluationDispatcher::getFitnessCache() const
+{
+	return _fitnessCache;
+}
+
+uint64_t EvaluationDispatcher::getNumMerged() const
+{
+	return _numMerged;
+}
+
 EvaluationDispatcher::~EvaluationDispatcher()
 {
 	if (bSetup) {
 		_evalQueue.close();
 		_updateQueue.close();
-		waitForThread(true);
+		for (auto& worker : _workers) {
+			worker->waitForThread(true);
+		}
 		ofRemoveListener(ofEvents().update, this, &EvaluationDispatcher::update);
 	}
 }
@@ -2,28 +2,61 @@
 #include "ofThread.h"
 #include "ofThreadChannel.h"
 #include "Artifact/EvaluationType.h"
+#include "Artifact/FitnessCache.h"
 #include "Artifact/SimpleEvaluators.h"
+#include "Artifact/MaskCoverageEvaluator.h"
 #include "Artifact/AestheticEvaluator.h"
 #include "Artifact/OrderlyCoverageEvaluator.h"
+#include "Artifact/CompositeEvaluator.h"
 
-class EvaluationDispatcher : public ofThread 
+class EvaluationDispatcher
 {
 public:
     ofEvent<const std::vector<std::vector<double>>&> onFitnessResponseReady;
 
+    struct EvaluatorSettings
+    {
+        // Target image of MaskCoverage evaluation, relative to the data folder
+        std::string maskFile = "";
+
+        // Objectives of Composite evaluation and the weight of each in the combined fitness (missing weights are 1)
+        std::vector<EvaluationType> compositeTypes = { Coverage, OrderlyCoverage };
+        std::vector<double> compositeWeights;
+
+        // Intermediate images of Aesthetics and OrderlyCoverage evaluations in data/keep/, written by the first worker only
+        bool bWriteToDisk = false;
+
+        // Fractal encode of Aesthetics evaluation: domain search, the block error above which a classified search falls
+        // back to an exhaustive one, and evaluation at the artifact resolution instead of a fixed processing size
+        FractalCompressor::DomainSearch domainSearch = FractalCompressor::SEARCH_EXHAUSTIVE;
+        float searchFallbackError = 6.0f;
+        bool bNativeResolution = false;
+    };
+
     EvaluationDispatcher();
     ~EvaluationDispatcher();
 
-    void setup(EvaluationType type, uint32_t width, uint32_t height);
+    // numWorkers = 0 uses all hardware threads, numWorkerThreads = 0 splits the hardware threads among the workers
+    void setup(EvaluationType type, uint32_t width, uint32_t height, uint32_t numWorkers = 1, uint32_t numWorkerThreads = 1,
+        const EvaluatorSettings& evaluatorSettings = EvaluatorSettings());
+
+    // Artifacts identical to a cached or in-flight one are not evaluated again (capacity = 0 disables this)
+    void setupCache(size_t capacity, FitnessCache::Eviction eviction = FitnessCache::LRU);
     void queue(cv::Mat image, int generation = 0, int id = 0, bool report = true);
+
+    // Delivers results that are known without evaluating an artifact, in order with the queued artifacts
+    void queueResults(const std::vector<double>& results, int generation = 0, int id = 0, bool report = true);
     void queueResponse();
 
-private:
-    void update(ofEventArgs& a);
-    virtual void threadedFunction();
+    uint32_t getNumWorkers();
+    uint32_t getNumInFlight();
 
-    std::unique_ptr<EvaluatorBase> _evaluator;
+    const FitnessCache& getFitnessCache() const;
 
+    // Artifacts that matched one still being evaluated and took over its results
+    uint64_t getNumMerged() const;
+
+private:
     struct ArtifactEntry
     {
         ArtifactEntry() {}
@@ -34,11 +67,45 @@ private:
         int generation = 0;
         int id = 0;
         int report = 1;
-        int response = 0;
+        uint64_t sequence = 0;
+        uint64_t key = 0;
     };
+
+    // Evaluators hold mutable state, so every worker owns one
+    class Worker : public ofThread
+    {
+    public:
+        Worker(EvaluationDispatcher* dispatcher, std::unique_ptr<EvaluatorBase> evaluator);
+
+    private:
+        virtual void threadedFunction();
+
+        EvaluationDispatcher* _dispatcher;
+        std::unique_ptr<EvaluatorBase> _evaluator;
+    };
+
+    static std::unique_ptr<EvaluatorBase> createEvaluator(EvaluationType type, const EvaluatorSettings& settings);
+
+    void update(ofEventArgs& a);
+    void deliver(const ArtifactEntry& entry);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
     ofThreadChannel<ArtifactEntry> _evalQueue;
     ofThreadChannel<ArtifactEntry> _updateQueue;
 
-    std::vector<std::vector<double>> _fitnessQueue;
+    // Results are delivered in queue order, a response goes out once everything queued before it is delivered
+    std::map<uint64_t, ArtifactEntry> _completed;
+    std::deque<uint64_t> _responseBarriers;
+    uint64_t _nextSequence = 0;
+    uint64_t _nextDelivery = 0;
+
+    FitnessCache _fitnessCache;
+
+    // Entries waiting for an identical artifact in flight, by content key
+    std::unordered_map<uint64_t, std::vector<ArtifactEntry>> _pendingKeys;
+    uint64_t _numMerged = 0;
+
+    std::vector<ArtifactEntry> _fitnessQueue;
     bool bSetup = false;
 };
@@ -5,6 +5,8 @@ enum EvaluationType
     Coverage,
     CircleCoverage,
     InverseCircleCoverage,
+    MaskCoverage,
     OrderlyCoverage,
-    Aesthetics
+    Aesthetics,
+    Composite
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include "Artifact/FeatureContext.h"
 #include "ofxOpenCv.h"
 
 class EvaluatorBase
@@ -6,4 +7,14 @@ class EvaluatorBase
 public:
 	virtual void setup(uint32_t width, uint32_t height) = 0;
 	virtual std::vector<double> evaluate(cv::Mat im) = 0;
+
+	// Evaluates the artifact of a context that other evaluators may share. Evaluators that take their intermediates
+	// from the context override this, the others evaluate the artifact itself
+	virtual std::vector<double> evaluate(FeatureContext& context)
+	{
+		return evaluate(context.getImage());
+	}
+
+	// Threads an evaluator may use internally for a single evaluation
+	virtual void setNumThreads(uint32_t numThreads) {}
 };
@@ -0,0 +1,168 @@
+#include "FeatureContext.h"
+
+void FeatureContext::reset(const cv::Mat& im)
+{
+	_image = im;
+	_bCoverageValid = false;
+
+	for (auto& blur : _blur) {
+		blur.second.bValid = false;
+	}
+	_gradientX.bValid = false;
+	_gradientY.bValid = false;
+	_gradient.bValid = false;
+
+	for (Feature& level : _pyramid) {
+		level.bValid = false;
+	}
+	for (auto& child : _children) {
+		child.second.bValid = false;
+	}
+	_numComputed = 0;
+	_numReused = 0;
+}
+
+const cv::Mat& FeatureContext::getImage() const
+{
+	return _image;
+}
+
+cv::Size FeatureContext::getSize() const
+{
+	return _image.size();
+}
+
+bool FeatureContext::require(Feature& feature)
+{
+	if (feature.bValid) {
+		_numReused++;
+		return false;
+	}
+	feature.bValid = true;
+	_numComputed++;
+	return true;
+}
+
+double FeatureContext::getCoverage()
+{
+	if (_bCoverageValid) {
+		_numReused++;
+		return _coverage;
+	}
+	_coverage = cv::mean(_image)[0] / 255.0;
+	_bCoverageValid = true;
+	_numComputed++;
+	return _coverage;
+}
+
+const cv::Mat& FeatureContext::getBlur(int ksize)
+{
+	Feature& blur = _blur[ksize];
+	if (require(blur)) {
+		cv::blur(_image, blur.mat, cv::Size(ksize, ksize));
+	}
+	return blur.mat;
+}
+
+const cv::Mat& FeatureContext::getGradientX()
+{
+	if (require(_gradientX)) {
+		cv::Sobel(_image, _gradientX.mat, CV_16S, 1, 0, 1);
+	}
+	return _gradientX.mat;
+}
+
+const cv::Mat& FeatureContext::getGradientY()
+{
+	if (require(_gradientY)) {
+		cv::Sobel(_image, _gradientY.mat, CV_16S, 0, 1, 1);
+	}
+	return _gradientY.mat;
+}
+
+const cv::Mat& FeatureContext::getGradient()
+{
+	if (require(_gradient)) {
+		cv::Mat absGradX, absGradY;
+		cv::convertScaleAbs(getGradientX(), absGradX);
+		cv::convertScaleAbs(getGradientY(), absGradY);
+		cv::addWeighted(absGradX, 0.5, absGradY, 0.5, 0, _gradient.mat);
+	}
+	return _gradient.mat;
+}
+
+const cv::Mat& FeatureContext::getPyramidLevel(int level)
+{
+	if (level <= 0) {
+		return _image;
+	}
+	if (_pyramid.size() < size_t(level)) {
+		_pyramid.resize(level);
+	}
+	Feature& feature = _pyramid[level - 1];
+	if (require(feature)) {
+		cv::pyrDown(getPyramidLevel(level - 1), feature.mat);
+	}
+	return feature.mat;
+}
+
+FeatureContext& FeatureContext::getResized(cv::Size size)
+{
+	if (size == _image.size()) {
+		return *this;
+	}
+	return getChild(std::make_tuple(0, 0, size.width, size.height, true), [this, size](Child& child) {
+		cv::resize(_image, child.buffer, size);
+	});
+}
+
+FeatureContext& FeatureContext::getRegion(cv::Rect region)
+{
+	region &= cv::Rect(0, 0, _image.cols, _image.rows);
+	if (region.size() == _image.size()) {
+		return *this;
+	}
+	return getChild(std::make_tuple(region.x, region.y, region.width, region.height, false), [this, region](Child& child) {
+		child.buffer = _image(region);
+	});
+}
+
+FeatureContext& FeatureContext::getChild(const std::tuple<int, int, int, int, bool>& key, const std::function<void(Child&)>& init)
+{
+	Child& child = _children[key];
+	if (!child.context) {
+		child.context = std::make_unique<FeatureContext>();
+	}
+	if (!child.bValid) {
+		init(child);
+		child.context->reset(child.buffer);
+		child.bValid = true;
+		_numComputed++;
+	}
+	else {
+		_numReused++;
+	}
+	return *child.context;
+}
+
+uint32_t FeatureContext::getNumComputed() const
+{
+	uint32_t num = _numComputed;
+	for (const auto& child : _children) {
+		if (child.second.bValid) {
+			num += child.second.context->getNumComputed();
+		}
+	}
+	return num;
+}
+
+uint32_t FeatureContext::getNumReused() const
+{
+	uint32_t num = _numReused;
+	for (const auto& child : _children) {
+		if (child.second.bValid) {
+			num += child.second.context->getNumReused();
+		}
+	}
+	return num;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "ofxOpenCv.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <tuple>
+
+// Intermediate images and measures of a single artifact, computed on first use and shared by every evaluator that
+// asks for them afterwards. Resized and cropped versions of the artifact are contexts of their own, so their features
+// are memoized as well. Buffers are kept when the context is reset for the next artifact.
+class FeatureContext
+{
+public:
+	// Drops every feature of the previous artifact. im must be CV_8UC1 and stay alive until the next reset
+	void reset(const cv::Mat& im);
+
+	const cv::Mat& getImage() const;
+	cv::Size getSize() const;
+
+	// Mean intensity [0..1]
+	double getCoverage();
+
+	// Box blur with a ksize x ksize kernel
+	const cv::Mat& getBlur(int ksize);
+
+	// Sobel derivatives (CV_16S, 3x1 kernel) and their mean absolute value (CV_8UC1)
+	const cv::Mat& getGradientX();
+	const cv::Mat& getGradientY();
+	const cv::Mat& getGradient();
+
+	// Gaussian pyramid, level 0 is the image itself
+	const cv::Mat& getPyramidLevel(int level);
+
+	// The artifact resized to size, or this context if it already has that size
+	FeatureContext& getResized(cv::Size size);
+
+	// A region of the artifact without copying it, or this context if the region covers all of it
+	FeatureContext& getRegion(cv::Rect region);
+
+	// Features computed and requests answered from memory since the last reset, children included
+	uint32_t getNumComputed() const;
+	uint32_t getNumReused() const;
+
+private:
+	struct Feature
+	{
+		cv::Mat mat;
+		bool bValid = false;
+	};
+
+	struct Child
+	{
+		std::unique_ptr<FeatureContext> context;
+		cv::Mat buffer;
+		bool bValid = false;
+	};
+
+	// Returns true if feature still has to be computed and counts the request
+	bool require(Feature& feature);
+	FeatureContext& getChild(const std::tuple<int, int, int, int, bool>& key, const std::function<void(Child&)>& init);
+
+	cv::Mat _image;
+
+	double _coverage = 0.0;
+	bool _bCoverageValid = false;
+
+	std::map<int, Feature> _blur;
+	Feature _gradientX;
+	Feature _gradientY;
+	Feature _gradient;
+	std::deque<Feature> _pyramid;
+
+	// By (x, y, width, height, resized)
+	std::map<std::tuple<int, int, int, int, bool>, Child> _children;
+
+	uint32_t _numComputed = 0;
+	uint32_t _numReused = 0;
+};
@@ -0,0 +1,119 @@
+#include "FitnessCache.h"
+#include "xxhash.h"
+
+void FitnessCache::setup(size_t capacity, Eviction eviction)
+{
+	_capacity = capacity;
+	_eviction = eviction;
+	clear();
+}
+
+void FitnessCache::clear()
+{
+	_entries.clear();
+	_index.clear();
+	_numHits = 0;
+	_numMisses = 0;
+	_numEvictions = 0;
+}
+
+uint64_t FitnessCache::hash(const cv::Mat& im)
+{
+	// Dimensions go into the seed so differently shaped artifacts with the same bytes get different keys
+	uint64_t seed = (uint64_t(im.rows) << 40) ^ (uint64_t(im.cols) << 16) ^ uint64_t(im.type());
+	const size_t rowBytes = im.cols * im.elemSize();
+
+	if (im.isContinuous()) {
+		return XXH64(im.data, rowBytes * im.rows, seed);
+	}
+	uint64_t h = seed;
+	for (int i = 0; i < im.rows; i++) {
+		h = XXH64(im.ptr(i), rowBytes, h);
+	}
+	return h;
+}
+
+bool FitnessCache::lookup(uint64_t key, std::vector<double>& results)
+{
+	auto it = _index.find(key);
+	if (it == _index.end()) {
+		_numMisses++;
+		return false;
+	}
+	if (_eviction == LRU) {
+		_entries.splice(_entries.end(), _entries, it->second);
+	}
+	results = it->second->results;
+	_numHits++;
+	return true;
+}
+
+void FitnessCache::insert(uint64_t key, const std::vector<double>& results)
+{
+	if (_capacity == 0) {
+		return;
+	}
+	auto it = _index.find(key);
+	if (it != _index.end()) {
+		it->second->results = results;
+		return;
+	}
+	if (_entries.size() >= _capacity) {
+		_index.erase(_entries.front().key);
+		_entries.pop_front();
+		_numEvictions++;
+	}
+	_entries.push_back({ key, results });
+	_index.emplace(key, std::prev(_entries.end()));
+}
+
+bool FitnessCache::isEnabled() const
+{
+	return _capacity > 0;
+}
+
+size_t FitnessCache::getCapacity() const
+{
+	return _capacity;
+}
+
+size_t FitnessCache::getSize() const
+{
+	return _entries.size();
+}
+
+FitnessCache::Eviction FitnessCache::getEviction() const
+{
+	return _eviction;
+}
+
+uint64_t FitnessCache::getNumHits() const
+{
+	return _numHits;
+}
+
+uint64_t FitnessCache::getNumMisses() const
+{
+	return _numMisses;
+}
+
+uint64_t FitnessCache::getNumEvictions() const
+{
+	return _numEvictions;
+}
+
+double FitnessCache::getHitRate() const
+{
+	uint64_t lookups = _numHits + _numMisses;
+	return lookups ? double(_numHits) / lookups : 0.0;
+}
+
+FitnessCache::Eviction FitnessCache::evictionFromString(const std::string& str)
+{
+	return (str.compare("fifo") == 0) ? FIFO : LRU;
+}
+
+std::string FitnessCache::evictionToString(Eviction eviction)
+{
+	return (eviction == FIFO) ? "fifo" : "lru";
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "ofxOpenCv.h"
+#include <list>
+#include <unordered_map>
+
+// Evaluation results keyed by artifact content. Evaluators are deterministic, so an artifact identical to one that
+// was evaluated before (most often a blank canvas of a creature that never painted) gets the cached results instead.
+// Keys are 64-bit xxHash digests of the pixels and dimensions, collisions are not checked for.
+// Not thread-safe, the dispatcher only uses it on the main thread.
+class FitnessCache
+{
+public:
+	// LRU refreshes an entry on every hit, FIFO evicts in insertion order regardless of hits
+	enum Eviction { LRU, FIFO };
+
+	// capacity = 0 disables the cache
+	void setup(size_t capacity, Eviction eviction = LRU);
+	void clear();
+
+	static uint64_t hash(const cv::Mat& im);
+
+	bool lookup(uint64_t key, std::vector<double>& results);
+	void insert(uint64_t key, const std::vector<double>& results);
+
+	bool isEnabled() const;
+	size_t getCapacity() const;
+	size_t getSize() const;
+	Eviction getEviction() const;
+
+	uint64_t getNumHits() const;
+	uint64_t getNumMisses() const;
+	uint64_t getNumEvictions() const;
+	double getHitRate() const;
+
+	static Eviction evictionFromString(const std::string& str);
+	static std::string evictionToString(Eviction eviction);
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		std::vector<double> results;
+	};
+
+	// Front is the next entry to evict
+	std::list<Entry> _entries;
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> _index;
+
+	size_t _capacity = 0;
+	Eviction _eviction = LRU;
+
+	uint64_t _numHits = 0;
+	uint64_t _numMisses = 0;
+	uint64_t _numEvictions = 0;
+};
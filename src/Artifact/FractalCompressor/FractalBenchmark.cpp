@@ -0,0 +1,98 @@
+#include "FractalBenchmark.h"
+#include "ofLog.h"
+#include "ofUtils.h"
+#include "ofMath.h"
+#include <cfloat>
+
+int FractalBenchmark::run(std::string imagePath, int iterations)
+{
+	cv::Mat im;
+	if (!imagePath.empty()) {
+		im = cv::imread(imagePath, cv::IMREAD_GRAYSCALE);
+		if (im.empty()) {
+			ofLogError() << "[FractalBenchmark] Could not load " << imagePath;
+			return 1;
+		}
+	}
+	else {
+		im = createArtifact(256);
+	}
+	ofLog() << "[FractalBenchmark] " << im.cols << "x" << im.rows << ", block size " << _blockSize << ", best of " << iterations;
+
+	struct Config { FractalCompressor::ContrastFit fit; FractalKernels::Level level; FractalCompressor::DomainSearch search; float fallbackError; };
+	std::vector<Config> configs;
+	for (int level = FractalKernels::SCALAR; level <= FractalKernels::getSupportedLevel(); level++) {
+		configs.push_back({ FractalCompressor::CONTRAST_LEAST_SQUARES, FractalKernels::Level(level), FractalCompressor::SEARCH_EXHAUSTIVE, 0.0f });
+	}
+	configs.push_back({ FractalCompressor::CONTRAST_SWEEP, FractalKernels::SCALAR, FractalCompressor::SEARCH_EXHAUSTIVE, 0.0f });
+
+	// Classified search with decreasing fallback thresholds, from no fallback at all towards the exhaustive result
+	for (float fallbackError : { FLT_MAX, 6.0f, 3.0f }) {
+		configs.push_back({ FractalCompressor::CONTRAST_LEAST_SQUARES, FractalKernels::getSupportedLevel(), FractalCompressor::SEARCH_CLASSIFIED, fallbackError });
+	}
+
+	for (const Config& config : configs) {
+		FractalCompressor compressor;
+		compressor.setup(_blockSize);
+		compressor.setContrastFit(config.fit);
+		compressor.setKernelLevel(config.level);
+		compressor.setDomainSearch(config.search, config.fallbackError);
+
+		uint64_t best = UINT64_MAX;
+		for (int i = 0; i < std::max(iterations, 1); i++) {
+			compressor.allocate(im);
+			uint64_t start = ofGetElapsedTimeMicros();
+			compressor.encode();
+			best = std::min(best, ofGetElapsedTimeMicros() - start);
+		}
+		compressor.decode(_decodingDepth);
+
+		uint64_t error = 0;
+		for (int i = 0; i < compressor.getNumBlocks(); i++) {
+			error += compressor.getEncodingResultPtr()[i].error;
+		}
+
+		std::string search = "exhaustive";
+		if (config.search == FractalCompressor::SEARCH_CLASSIFIED) {
+			search = (config.fallbackError == FLT_MAX) ? "classified" : "classified<" + ofToString(config.fallbackError);
+		}
+		const FractalCompressor::SearchStats& stats = compressor.getSearchStats();
+
+		char msg[320];
+		sprintf(msg, "%-6s %-6s %-14s %9.1fms %10.0f blocks/s  compared %5.1f%%  fallbacks %5d  mean SAD %7.1f  rmse@%d %.3f",
+			config.fit == FractalCompressor::CONTRAST_SWEEP ? "sweep" : "lsq",
+			FractalKernels::getLevelName(config.level),
+			search.c_str(),
+			best / 1000.0,
+			compressor.getNumBlocks() * 1000000.0 / std::max(best, uint64_t(1)),
+			stats.candidates * 100.0 / std::max(stats.exhaustiveCandidates, uint64_t(1)),
+			stats.fallbacks,
+			error / double(compressor.getNumBlocks()),
+			_decodingDepth, rmse(compressor.getDecodedImage(), im)
+		);
+		ofLog() << msg;
+	}
+	return 0;
+}
+
+// Soft dark strokes on a light canvas, similar to what the creatures paint
+cv::Mat FractalBenchmark::createArtifact(int size)
+{
+	cv::Mat im(size, size, CV_8UC1, cv::Scalar(0));
+	ofSeedRandom(1);
+	for (int i = 0; i < 48; i++) {
+		cv::Point a(ofRandom(size), ofRandom(size));
+		cv::Point b(a.x + ofRandom(-size / 4, size / 4), a.y + ofRandom(-size / 4, size / 4));
+		cv::line(im, a, b, cv::Scalar(ofRandom(128, 255)), ofRandom(1, 6), cv::LINE_AA);
+	}
+	cv::GaussianBlur(im, im, cv::Size(5, 5), 0);
+	return im;
+}
+
+double FractalBenchmark::rmse(const cv::Mat& a, const cv::Mat& b)
+{
+	cv::Mat diff;
+	cv::absdiff(a, b, diff);
+	diff.convertTo(diff, CV_64F);
+	return std::sqrt(cv::mean(diff.mul(diff))[0]);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "FractalCompressor.h"
+
+// Microbenchmark for the fractal block matcher (neatures --fractal-bench [image] [iterations]).
+// Encodes the image, or a synthetic artifact, with every supported kernel level and contrast fit, then with the
+// classified domain search, and reports range blocks matched per second, the share of exhaustive comparisons made,
+// and the encoding error and decoded RMSE of each configuration.
+class FractalBenchmark
+{
+public:
+	int run(std::string imagePath = "", int iterations = 3);
+
+private:
+	cv::Mat createArtifact(int size);
+	double rmse(const cv::Mat& a, const cv::Mat& b);
+
+	int _blockSize = 8;
+	int _decodingDepth = 4;
+};
@@ -6,6 +6,7 @@
 
 #pragma once
 #include <stdio.h>
+#include <algorithm>
 
 #include "FractalCompressor.h"
 #include "FractalCompressorCommon.h"
@@ -13,6 +14,24 @@
 void FractalCompressor::setup(int blockSize)
 {
 	m_blockSize = blockSize;
+	m_blockArea = blockSize * blockSize;
+
+	m_isometryIndex.resize(8 * m_blockArea);
+	for (int n = 0; n < 8; n++) {
+		IsometryIndex(n, m_blockSize, &m_isometryIndex[n * m_blockArea]);
+	}
+
+	// Contrast scales of the brute-force search, accumulated the same way as the original loop
+	m_alphas.clear();
+	for (double d = 0.3; d <= 1.0; d += 0.1) {
+		m_alphas.push_back(d);
+	}
+	m_alphaTables.resize(m_alphas.size() * 511);
+	for (int a = 0; a < m_alphas.size(); a++) {
+		for (int v = -255; v <= 255; v++) {
+			m_alphaTables[a * 511 + v + 255] = (int)(m_alphas[a] * v + 0.5);
+		}
+	}
 }
 
 bool FractalCompressor::allocate(cv::Mat im)
@@ -22,18 +41,21 @@ bool FractalCompressor::allocate(cv::Mat im)
 		m_bMemoryAllocated = false;
 	}
 	if (m_blockSize > 0) {
-		m_imageWidth = im.rows;
-		m_imageHeight = im.cols;
+		m_imageWidth = im.cols;
+		m_imageHeight = im.rows;
 
-		m_imageData = ConvertFromMat(im);
-		m_decodedImageData = IntAlloc2(m_imageWidth, m_imageHeight);
+		m_imageData.resize(m_imageWidth * m_imageHeight);
 		for (int i = 0; i < m_imageHeight; i++) {
+			const unsigned char* row = im.ptr<unsigned char>(i);
 			for (int j = 0; j < m_imageWidth; j++) {
-				m_decodedImageData[i][j] = 0x80;
+				m_imageData[i * m_imageWidth + j] = row[j];
 			}
 		}
-		m_imageEncoding = ERAlloc2(m_imageWidth / m_blockSize, m_imageHeight / m_blockSize);
+		m_decodedImageData.assign(m_imageWidth * m_imageHeight, 0x80);
+		m_decodeBuffer.resize(m_imageWidth * m_imageHeight);
+
 		m_numBlocks = (m_imageWidth / m_blockSize) * (m_imageHeight / m_blockSize);
+		m_imageEncoding.assign(m_numBlocks, EncodingResult());
 		m_encodingBytes = m_numBlocks * sizeof(EncodingResult);
 
 		m_currentDecodingDepth = 0;
@@ -43,30 +65,283 @@ bool FractalCompressor::allocate(cv::Mat im)
 	else return false;
 }
 
+void FractalCompressor::buildDomainPool()
+{
+	m_domains.clear();
+	for (int i = 0; i < m_imageHeight - (m_blockSize * 2); i += m_blockSize) {
+		for (int j = 0; j < m_imageWidth - (m_blockSize * 2); j += m_blockSize) {
+			m_domains.push_back({ j, i, 0, 0 });
+		}
+	}
+
+	// Over-allocate so the variants can start on a cache line
+	const size_t alignment = 64 / sizeof(int16_t);
+	m_domainStorage.resize(m_domains.size() * 8 * m_blockArea + alignment);
+	size_t offset = (alignment - (reinterpret_cast<uintptr_t>(m_domainStorage.data()) / sizeof(int16_t)) % alignment) % alignment;
+	m_domainVariants = m_domainStorage.data() + offset;
+
+	// Every domain writes only its own entry and variants
+	m_jobSystem.parallelFor(m_domains.size(), [this](size_t d) {
+		std::vector<int> contracted(m_blockArea);
+		Domain& domain = m_domains[d];
+		Contraction(m_imageData.data(), m_imageWidth, domain.x, domain.y, m_blockSize, contracted.data());
+		domain.avg = ComputeAVG(contracted.data(), m_blockArea);
+
+		domain.norm = 0;
+		for (int k = 0; k < m_blockArea; k++) {
+			contracted[k] -= domain.avg;
+			domain.norm += contracted[k] * contracted[k];
+		}
+
+		for (int n = 0; n < 8; n++) {
+			int16_t* variant = m_domainVariants + (size_t(d) * 8 + n) * m_blockArea;
+			const int* index = &m_isometryIndex[n * m_blockArea];
+			for (int k = 0; k < m_blockArea; k++) {
+				variant[k] = contracted[index[k]];
+			}
+		}
+	});
+
+	// Serial pass keeps the candidates of every class in the order of the exhaustive search
+	m_classCandidates.assign(NUM_VARIANCE_BUCKETS * NUM_ORDERINGS, std::vector<uint32_t>());
+	for (size_t d = 0; d < m_domains.size(); d++) {
+		int bucket = getVarianceBucket(m_domains[d].norm);
+		for (int n = 0; n < 8; n++) {
+			m_classCandidates[bucket * NUM_ORDERINGS + getQuadrantOrdering(getDomainVariant(d, n))].push_back(d * 8 + n);
+		}
+	}
+}
+
+// Index [0..23] of the permutation that orders the quadrant sums of the block from bright to dark, ties in
+// quadrant order
+int FractalCompressor::getQuadrantOrdering(const int16_t* block) const
+{
+	const int half = m_blockSize / 2;
+	int sums[4] = { 0, 0, 0, 0 };
+	for (int y = 0; y < m_blockSize; y++) {
+		for (int x = 0; x < m_blockSize; x++) {
+			sums[(y >= half) * 2 + (x >= half)] += block[y * m_blockSize + x];
+		}
+	}
+
+	int order[4] = { 0, 1, 2, 3 };
+	std::stable_sort(order, order + 4, [&sums](int a, int b) { return sums[a] > sums[b]; });
+
+	// Lehmer code of the ordering
+	int cls = 0;
+	for (int i = 0; i < 3; i++) {
+		int smaller = 0;
+		for (int j = i + 1; j < 4; j++) {
+			smaller += order[j] < order[i];
+		}
+		cls = cls * (4 - i) + smaller;
+	}
+	return cls;
+}
+
+// 0 for (nearly) flat blocks, then one bucket per doubling of the variance
+int FractalCompressor::getVarianceBucket(int norm) const
+{
+	int bucket = 0;
+	for (int variance = norm / m_blockArea; variance > 0 && bucket < NUM_VARIANCE_BUCKETS - 1; variance >>= 1) {
+		bucket++;
+	}
+	return bucket;
+}
+
+const int16_t* FractalCompressor::getDomainVariant(int domain, int isometry) const
+{
+	return m_domainVariants + (size_t(domain) * 8 + isometry) * m_blockArea;
+}
+
 void FractalCompressor::encode()
 {
-	int** block_temp = (int**)IntAlloc2(m_blockSize, m_blockSize);
+	buildDomainPool();
 
-	for (int i = 0; i < m_imageHeight / m_blockSize; i++) {
-		for (int j = 0; j < m_imageWidth / m_blockSize; j++) {
-			ReadBlock(m_imageData, m_blockSize * j, m_blockSize * i, m_blockSize, m_blockSize, block_temp);
-			m_imageEncoding[i][j] = TemplateMatchingWithDownSamplingPlusShuffle_StructEncoding(block_temp, m_blockSize, m_blockSize, m_imageData, m_imageWidth, m_imageHeight, 1);
+	// Range blocks are matched independently, each row of blocks is a job that writes only its own results
+	const int blocksY = m_imageHeight / m_blockSize;
+	m_rowSearchStats.assign(blocksY, SearchStats());
+	m_jobSystem.parallelFor(blocksY, [this](size_t row) {
+		encodeBlockRow(row);
+	});
+
+	m_searchStats = SearchStats();
+	for (const SearchStats& stats : m_rowSearchStats) {
+		m_searchStats.candidates += stats.candidates;
+		m_searchStats.exhaustiveCandidates += stats.exhaustiveCandidates;
+		m_searchStats.fallbacks += stats.fallbacks;
+	}
 
-			if (m_bLog) {
-				printEncodingResult(m_imageEncoding, i, j);
+	if (m_bLog) {
+		for (int i = 0; i < blocksY; i++) {
+			for (int j = 0; j < m_imageWidth / m_blockSize; j++) {
+				printEncodingResult(i, j);
 			}
 		}
 	}
 	if (m_bEncToDisk) {
-		WriteParameter("data/keep/encoding.txt", m_imageEncoding, m_imageWidth / m_blockSize, m_imageHeight / m_blockSize);
+		WriteParameter("data/keep/encoding.txt", m_imageEncoding);
+	}
+}
+
+void FractalCompressor::encodeBlockRow(int row)
+{
+	std::vector<int> block(m_blockArea);
+	std::vector<int16_t> blockAC(m_blockArea);
+
+	const int blocksX = m_imageWidth / m_blockSize;
+	const size_t numVariants = m_domains.size() * 8;
+	for (int j = 0; j < blocksX; j++) {
+		for (int y = 0; y < m_blockSize; y++) {
+			for (int x = 0; x < m_blockSize; x++) {
+				block[y * m_blockSize + x] = m_imageData[(row * m_blockSize + y) * m_imageWidth + j * m_blockSize + x];
+			}
+		}
+		int blockAvg = ComputeAVG(block.data(), m_blockArea);
+		for (int k = 0; k < m_blockArea; k++) {
+			blockAC[k] = block[k] - blockAvg;
+		}
+		if (m_domainSearch == SEARCH_CLASSIFIED) {
+			m_imageEncoding[row * blocksX + j] = searchDomainClass(blockAC.data(), blockAvg, m_rowSearchStats[row]);
+		}
+		else {
+			m_imageEncoding[row * blocksX + j] = searchDomains(blockAC.data(), blockAvg, nullptr, numVariants, m_rowSearchStats[row].candidates);
+		}
+		m_rowSearchStats[row].exhaustiveCandidates += numVariants;
+	}
+}
+
+// Classified search, see DomainSearch. Falls back to the exhaustive search over the whole pool
+EncodingResult FractalCompressor::searchDomainClass(const int16_t* rangeAC, int rangeAvg, SearchStats& stats) const
+{
+	const size_t numVariants = m_domains.size() * 8;
+
+	int norm = 0;
+	for (int k = 0; k < m_blockArea; k++) {
+		norm += rangeAC[k] * rangeAC[k];
+	}
+	const int ordering = getQuadrantOrdering(rangeAC);
+	const int bucket = getVarianceBucket(norm);
+
+	// Buckets are searched from low to high variance and only a strictly better match replaces the best one
+	EncodingResult result = {};
+	bool bFound = false;
+	for (int b = bucket; b < std::min(bucket + SEARCH_BUCKET_SPAN, NUM_VARIANCE_BUCKETS); b++) {
+		const std::vector<uint32_t>& candidates = m_classCandidates[b * NUM_ORDERINGS + ordering];
+		if (candidates.empty()) {
+			continue;
+		}
+		EncodingResult match = searchDomains(rangeAC, rangeAvg, candidates.data(), candidates.size(), stats.candidates);
+		if (!bFound || match.error < result.error) {
+			result = match;
+			bFound = true;
+		}
+	}
+	if (bFound && result.error <= m_searchFallbackError * m_blockArea) {
+		return result;
+	}
+	stats.fallbacks++;
+	return searchDomains(rangeAC, rangeAvg, nullptr, numVariants, stats.candidates);
+}
+
+EncodingResult FractalCompressor::searchDomains(const int16_t* rangeAC, int rangeAvg, const uint32_t* candidates, size_t numCandidates, uint64_t& numCompared) const
+{
+	return (m_contrastFit == CONTRAST_SWEEP) ?
+		matchBlockSweep(rangeAC, rangeAvg, candidates, numCandidates, numCompared) :
+		matchBlock(rangeAC, rangeAvg, candidates, numCandidates, numCompared);
+}
+
+// Search over the given domain/isometry pairs, or all of them in order if candidates is null. The contrast scale of
+// every pair is the least squares solution <r,v>/<v,v>, clamped to the range of the sweep, so every candidate costs
+// one dot product and one SAD.
+EncodingResult FractalCompressor::matchBlock(const int16_t* rangeAC, int rangeAvg, const uint32_t* candidates, size_t numCandidates, uint64_t& numCompared) const
+{
+	const int alphaMin = int(m_alphas.front() * 32768.0);
+	const int alphaMax = 32767;
+
+	EncodingResult result = {};
+	result.avg = rangeAvg;
+	int errorMin = INT_MAX;
+
+	for (size_t c = 0; c < numCandidates; c++) {
+		numCompared++;
+		const uint32_t v = candidates ? candidates[c] : uint32_t(c);
+		const int d = v / 8;
+		const int n = v % 8;
+		const int norm = m_domains[d].norm;
+		const int16_t* variant = getDomainVariant(d, n);
+
+		int alpha = alphaMin;
+		if (norm > 0) {
+			int dot = m_kernels->dot(rangeAC, variant, m_blockArea);
+			alpha = std::min(std::max(int(std::lround(dot * 32768.0 / norm)), alphaMin), alphaMax);
+		}
+		int error = m_kernels->scaledSad(rangeAC, variant, int16_t(alpha), m_blockArea);
+
+		if (error < errorMin) {
+			errorMin = error;
+			result.x = m_domains[d].x;
+			result.y = m_domains[d].y;
+			result.alpha = alpha / 32768.0;
+			result.geo = n;
+			result.error = error;
+
+			// Nothing can replace an exact match, common on the flat canvas around the strokes
+			if (error == 0) {
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+// Reference search over the alpha sweep. Candidates are visited in the order of the original implementation and only
+// replace the best match if strictly better, so the exhaustive encoding is identical to it.
+EncodingResult FractalCompressor::matchBlockSweep(const int16_t* rangeAC, int rangeAvg, const uint32_t* candidates, size_t numCandidates, uint64_t& numCompared) const
+{
+	EncodingResult result = {};
+	result.avg = rangeAvg;
+	int errorMin = INT_MAX;
+
+	for (size_t c = 0; c < numCandidates; c++) {
+		numCompared++;
+		const uint32_t v = candidates ? candidates[c] : uint32_t(c);
+		const int d = v / 8;
+		const int n = v % 8;
+		const int16_t* variant = getDomainVariant(d, n);
+
+		for (int a = 0; a < m_alphas.size(); a++) {
+			const int* scale = &m_alphaTables[a * 511 + 255];
+
+			// Partial sums only grow, so stop as soon as this candidate can no longer win
+			int error = 0;
+			for (int y = 0; y < m_blockSize && error < errorMin; y++) {
+				const int16_t* r = rangeAC + y * m_blockSize;
+				const int16_t* s = variant + y * m_blockSize;
+				for (int x = 0; x < m_blockSize; x++) {
+					error += abs(r[x] - scale[s[x]]);
+				}
+			}
+			if (error < errorMin) {
+				errorMin = error;
+				result.x = m_domains[d].x;
+				result.y = m_domains[d].y;
+				result.alpha = m_alphas[a];
+				result.geo = n;
+				result.error = error;
+			}
+		}
+		if (errorMin == 0) {
+			break;
+		}
 	}
-	IntFree2(block_temp, m_blockSize, m_blockSize);
+	return result;
 }
 
 void FractalCompressor::decode(int depth)
 {
 	for (int i = 0; i < depth; i++) {
-		Decoding(m_imageEncoding, m_decodedImageData, m_imageWidth, m_imageHeight, m_blockSize, m_blockSize);
+		decodeStep(m_imageEncoding);
 		m_currentDecodingDepth++;
 		if (m_bImageToDisk) {
 			std::string fname = "data/keep/decoded_out_" + ofToString(m_currentDecodingDepth) + ".bmp";
@@ -77,11 +352,11 @@ void FractalCompressor::decode(int depth)
 
 void FractalCompressor::decodeFromFile(int depth)
 {
-	EncodingResult** en_result = ERAlloc2(m_imageWidth / m_blockSize, m_imageHeight / m_blockSize);
-	ReadParameter("data/keep/encoding.txt", en_result, m_imageWidth / m_blockSize, m_imageHeight / m_blockSize);
+	std::vector<EncodingResult> en_result(m_numBlocks);
+	ReadParameter("data/keep/encoding.txt", en_result);
 
 	for (int i = 0; i < depth; i++) {
-		Decoding(en_result, m_decodedImageData, m_imageWidth, m_imageHeight, m_blockSize, m_blockSize);
+		decodeStep(en_result);
 		if (m_bImageToDisk) {
 			std::string fname = "data/keep/decoded_out_" + ofToString(i) + ".bmp";
 			cv::imwrite(fname, getDecodedImage());
@@ -89,100 +364,52 @@ void FractalCompressor::decodeFromFile(int depth)
 	}
 }
 
-EncodingResult FractalCompressor::TemplateMatchingWithDownSamplingPlusShuffle_StructEncoding(int** block, int bx, int by, int** image, int width, int height, double alpha)
-{
-	EncodingResult struct_Tmp;
-	int error_min = INT_MAX;
-
-	int** temp = (int**)IntAlloc2(bx * 2, by * 2);
-	int** domain = (int**)IntAlloc2(bx, by);
-	int** tmp_test = (int**)IntAlloc2(bx, by);
-	int block_avg = ComputeAVG(block, bx, by);
-	struct_Tmp.avg = block_avg;
-	int** block_AC = (int**)IntAlloc2(bx, by);
-	int** domain_AC = (int**)IntAlloc2(bx, by);
-
-	Copy_img(block, bx, by, block_AC);
-	Find_AC(block_AC, bx, by, block_avg);
-
-	for (int i = 0; i < height - (by * 2); i += by) {
-		for (int j = 0; j < width - (bx * 2); j += bx) {
-			ReadBlock(image, j, i, bx * 2, by * 2, temp);
-			Contraction(temp, domain, bx * 2, by * 2);
-			int domain_avg = ComputeAVG(domain, bx, by);
-			for (int n = 0; n < 8; n++) {
-				Isometry(n, domain, bx, by, tmp_test);
-				Find_AC(tmp_test, bx, by, domain_avg);
-				for (double d = 0.3; d <= 1.0; d += 0.1) {
-					AC_control(tmp_test, bx, by, d, domain_AC);
-					int error = ComputeAbsError(block_AC, bx, domain_AC, bx, by, 0, 0);
-					if (error < error_min) {
-						error_min = error;
-						struct_Tmp.x = j;
-						struct_Tmp.y = i;
-						struct_Tmp.alpha = d;
-						struct_Tmp.geo = n;
-						struct_Tmp.error = error;
-					}
-				}
-			}
-		}
-	}
-	IntFree2(temp, bx * 2, by * 2);
-	IntFree2(domain, bx, by);
-	IntFree2(block_AC, bx, by);
-	IntFree2(domain_AC, bx, by);
-	IntFree2(tmp_test, bx, by);
+// Applies every block transform once to the current decoded image
+void FractalCompressor::decodeStep(const std::vector<EncodingResult>& encoding)
+{
+	std::vector<int> contracted(m_blockArea);
 
-	return struct_Tmp;
-}
+	const int blocksX = m_imageWidth / m_blockSize;
+	for (int i = 0; i < m_imageHeight / m_blockSize; i++) {
+		for (int j = 0; j < blocksX; j++) {
+			const EncodingResult& e = encoding[i * blocksX + j];
 
-void FractalCompressor::Decoding(EncodingResult** en_Result, int** image_dec, int width, int height, int size_x, int size_y)
-{
-	int** block = IntAlloc2(size_x * 2, size_y * 2);
-	int** block_contract_tmp = IntAlloc2(size_x, size_y);
-	int** block_contract_tmp_aftercontrol = IntAlloc2(size_x, size_y);
-	int** image_dec_tmp = IntAlloc2(width, height);
+			Contraction(m_decodedImageData.data(), m_imageWidth, e.x, e.y, m_blockSize, contracted.data());
+			int avg = ComputeAVG(contracted.data(), m_blockArea);
 
-	for (int i = 0; i < height / size_y; i++) {
-		for (int j = 0; j < width / size_x; j++) {
-			ReadBlock(image_dec, en_Result[i][j].x, en_Result[i][j].y, size_x * 2, size_y * 2, block);
-			Contraction(block, block_contract_tmp, size_x * 2, size_y * 2);
-			int b_avg = ComputeAVG(block_contract_tmp, size_x, size_y);
-			Find_AC(block_contract_tmp, size_x, size_y, b_avg);
-			Isometry(en_Result[i][j].geo, block_contract_tmp, size_x, size_y, block_contract_tmp_aftercontrol);
-			AC_control(block_contract_tmp_aftercontrol, size_x, size_y, en_Result[i][j].alpha, block_contract_tmp_aftercontrol);
-			Find_AC(block_contract_tmp_aftercontrol, size_x, size_y, -en_Result[i][j].avg);
-			WriteBlock(image_dec_tmp, j * size_x, i * size_y, size_x, size_y, block_contract_tmp_aftercontrol);
+			const int* index = &m_isometryIndex[e.geo * m_blockArea];
+			for (int y = 0; y < m_blockSize; y++) {
+				int* out = &m_decodeBuffer[(i * m_blockSize + y) * m_imageWidth + j * m_blockSize];
+				for (int x = 0; x < m_blockSize; x++) {
+					int v = contracted[index[y * m_blockSize + x]] - avg;
+					out[x] = (int)(e.alpha * v + 0.5) + e.avg;
+				}
+			}
 		}
 	}
-	Copy_img(image_dec_tmp, width, height, image_dec);
-
-	IntFree2(block, size_x * 2, size_y * 2);
-	IntFree2(block_contract_tmp, size_x, size_y);
-	IntFree2(block_contract_tmp_aftercontrol, size_x, size_y);
-	IntFree2(image_dec_tmp, width, height);
+	std::swap(m_decodedImageData, m_decodeBuffer);
 }
 
-void FractalCompressor::printEncodingResult(EncodingResult** en_result, int block_x, int block_y)
+void FractalCompressor::printEncodingResult(int block_x, int block_y)
 {
 	int i = block_x;
 	int j = block_y;
+	const EncodingResult& e = m_imageEncoding[i * (m_imageWidth / m_blockSize) + j];
 
-	printf(" < %3d , %3d > xǥ : %3d   yǥ : %3d  err : %3d Isom : %3d  alpha : %.1lf  avg : %3d \n",
+	printf(" < %3d , %3d > x : %3d   y : %3d  err : %3d Isom : %3d  alpha : %.1lf  avg : %3d \n",
 		j * m_blockSize, i * m_blockSize,
-		en_result[i][j].x,
-		en_result[i][j].y,
-		en_result[i][j].error,
-		en_result[i][j].geo,
-		en_result[i][j].alpha,
-		en_result[i][j].avg
+		e.x,
+		e.y,
+		e.error,
+		e.geo,
+		e.alpha,
+		e.avg
 	);
 }
 
 const EncodingResult* FractalCompressor::getEncodingResultPtr() const
 {
-	return &m_imageEncoding[0][0];
+	return m_imageEncoding.data();
 }
 
 int FractalCompressor::getNumBlocks()
@@ -197,7 +424,13 @@ size_t FractalCompressor::getEncodingBytes()
 
 cv::Mat FractalCompressor::getDecodedImage()
 {
-	return ConvertToMat(m_decodedImageData, m_imageWidth, m_imageHeight);
+	cv::Mat img(m_imageHeight, m_imageWidth, CV_8UC1);
+	for (int i = 0; i < img.rows; i++) {
+		for (int j = 0; j < img.cols; j++) {
+			img.at<unsigned char>(i, j) = (unsigned char)m_decodedImageData[i * m_imageWidth + j];
+		}
+	}
+	return img;
 }
 
 void FractalCompressor::setLog(bool enable) {
@@ -209,12 +442,35 @@ void FractalCompressor::setWriteEncodingToDisk(bool enable) {
 void FractalCompressor::setWriteImageToDisk(bool enable) {
 	m_bImageToDisk = enable;
 }
+void FractalCompressor::setContrastFit(ContrastFit fit) {
+	m_contrastFit = fit;
+}
+void FractalCompressor::setKernelLevel(FractalKernels::Level level) {
+	m_kernels = &FractalKernels::get(level);
+}
+void FractalCompressor::setNumThreads(uint32_t numThreads) {
+	m_jobSystem.setup(numThreads);
+}
+void FractalCompressor::setDomainSearch(DomainSearch search, float fallbackError) {
+	m_domainSearch = search;
+	m_searchFallbackError = fallbackError;
+}
+
+const FractalCompressor::SearchStats& FractalCompressor::getSearchStats() const
+{
+	return m_searchStats;
+}
 
 void FractalCompressor::dealloc()
 {
 	if (m_bMemoryAllocated) {
-		ERFree2(m_imageEncoding, m_imageWidth / m_numBlocks, m_imageHeight / m_numBlocks);
-		IntFree2(m_imageData, m_imageWidth, m_imageHeight);
-		IntFree2(m_decodedImageData, m_imageWidth, m_imageHeight);
+		m_imageData.clear();
+		m_decodedImageData.clear();
+		m_decodeBuffer.clear();
+		m_imageEncoding.clear();
+		m_domains.clear();
+		m_domainStorage.clear();
+		m_domainVariants = nullptr;
+		m_classCandidates.clear();
 	}
 }
@@ -6,6 +6,8 @@
 
 #pragma once
 #include "EncodingResult.h"
+#include "FractalKernels.h"
+#include "Utils/JobSystem.h"
 #include "ofPixels.h"
 #include "ofxOpenCv.h"
 #include "ofFileUtils.h"
@@ -13,6 +15,30 @@
 class FractalCompressor
 {
 public:
+	// Contrast scale per domain/isometry pair: least squares fit (default), or the original sweep over 0.3..1.0 in
+	// steps of 0.1 which reproduces the reference encoder exactly. Least squares encodings differ from the sweep:
+	// on 128x128 to 256x256 artifacts the summed block error stays within 3% of it and the decoded RMSE after 4
+	// iterations is within 0.2 gray levels or lower (see --fractal-bench).
+	enum ContrastFit { CONTRAST_LEAST_SQUARES, CONTRAST_SWEEP };
+
+	// Domain search per range block: every domain/isometry pair (default), or only the pairs in a matching class.
+	// Classes follow Fisher's scheme: the brightness ordering of the four quadrants of the mean-removed block (one of
+	// 24 permutations), combined with a log2 bucket of its variance. The contrast scale is positive and in [0.3..1],
+	// so the best match usually shares the ordering of the range block and has an equal or up to ~11x higher
+	// variance; a range block is compared against its own ordering in its own and the next 3 variance buckets.
+	// A classified search falls back to the exhaustive one when there are no candidates or the best one has a mean
+	// absolute error per pixel above the fallback threshold.
+	enum DomainSearch { SEARCH_EXHAUSTIVE, SEARCH_CLASSIFIED };
+
+	// Domain/isometry pairs compared during the last encode, against the number an exhaustive search without early
+	// exits would compare, to report the speed/quality trade-off of the domain search
+	struct SearchStats
+	{
+		uint64_t candidates = 0;
+		uint64_t exhaustiveCandidates = 0;
+		int fallbacks = 0;
+	};
+
 	void setup(int blockSize);
 	bool allocate(cv::Mat im);
 
@@ -29,18 +55,85 @@ public:
 	void setLog(bool enable);
 	void setWriteEncodingToDisk(bool enable);
 	void setWriteImageToDisk(bool enable);
+	void setContrastFit(ContrastFit fit);
+	void setKernelLevel(FractalKernels::Level level);
+	void setDomainSearch(DomainSearch search, float fallbackError = 6.0f);
+
+	const SearchStats& getSearchStats() const;
+
+	// Threads used to build the domain pool and match range blocks (0: hardware threads, 1: calling thread only).
+	// The encoding does not depend on the number of threads.
+	void setNumThreads(uint32_t numThreads);
 
 	void dealloc();
 
 private:
-	EncodingResult** m_imageEncoding;
-	int** m_imageData;
-	int** m_decodedImageData;
+	// Domain blocks are read from a grid with a stride of one range block and contracted 2x
+	struct Domain
+	{
+		int x;
+		int y;
+		int avg;
+		int norm;	// sum of squares of the mean-removed block, the same for every isometry
+	};
+
+	static const int NUM_ORDERINGS = 24;
+	static const int NUM_VARIANCE_BUCKETS = 16;
+	static const int SEARCH_BUCKET_SPAN = 4;
+
+	void buildDomainPool();
+	int getQuadrantOrdering(const int16_t* block) const;
+	int getVarianceBucket(int norm) const;
+	const int16_t* getDomainVariant(int domain, int isometry) const;
+
+	void encodeBlockRow(int row);
+	EncodingResult searchDomainClass(const int16_t* rangeAC, int rangeAvg, SearchStats& stats) const;
+	EncodingResult searchDomains(const int16_t* rangeAC, int rangeAvg, const uint32_t* candidates, size_t numCandidates, uint64_t& numCompared) const;
+	EncodingResult matchBlock(const int16_t* rangeAC, int rangeAvg, const uint32_t* candidates, size_t numCandidates, uint64_t& numCompared) const;
+	EncodingResult matchBlockSweep(const int16_t* rangeAC, int rangeAvg, const uint32_t* candidates, size_t numCandidates, uint64_t& numCompared) const;
+	void decodeStep(const std::vector<EncodingResult>& encoding);
+
+	void printEncodingResult(int block_x, int block_y);
+
+	// Row-major image buffers. Decoding may leave [0..255], so values are kept as int until converted to a Mat
+	std::vector<int> m_imageData;
+	std::vector<int> m_decodedImageData;
+	std::vector<int> m_decodeBuffer;
+	std::vector<EncodingResult> m_imageEncoding;
+
+	// Domain pool, built once per image: 8 mean-removed isometries of every contracted domain block,
+	// stored back to back in a single 64-byte aligned buffer
+	std::vector<Domain> m_domains;
+	std::vector<int16_t> m_domainStorage;
+	int16_t* m_domainVariants = nullptr;
+
+	// Domain/isometry pairs (domain * 8 + isometry) of every class (variance bucket * 24 + ordering), in ascending order
+	std::vector<std::vector<uint32_t>> m_classCandidates;
+
+	// Source index of every block element for each isometry
+	std::vector<int> m_isometryIndex;
+	std::vector<double> m_alphas;
+
+	// (int)(alpha * v + 0.5) for every mean-removed value v in [-255..255], one table per alpha
+	std::vector<int> m_alphaTables;
+
+	ContrastFit m_contrastFit = CONTRAST_LEAST_SQUARES;
+	const FractalKernels::Kernels* m_kernels = &FractalKernels::get();
+
+	DomainSearch m_domainSearch = SEARCH_EXHAUSTIVE;
+	float m_searchFallbackError = 6.0f;
+
+	// Per row of range blocks so the parallel rows never share counters
+	std::vector<SearchStats> m_rowSearchStats;
+	SearchStats m_searchStats;
+
+	JobSystem m_jobSystem;
 
 	int m_imageWidth = 0;
 	int m_imageHeight = 0;
 
 	int m_blockSize = 8;
+	int m_blockArea = 64;
 	int m_numBlocks = 0;
 	int m_encodingBytes = 0;
 	int m_currentDecodingDepth = 0;
@@ -50,9 +143,4 @@ private:
 	bool m_bImageToDisk = false;
 
 	bool m_bMemoryAllocated = false;
-
-	EncodingResult TemplateMatchingWithDownSamplingPlusShuffle_StructEncoding(int** block, int bx, int by, int** image, int width, int height, double alpha);
-	void Decoding(EncodingResult** en_Result, int** image_dec, int width, int height, int size_x, int size_y);
-
-	void printEncodingResult(EncodingResult** en_result, int block_x, int block_y);
 };
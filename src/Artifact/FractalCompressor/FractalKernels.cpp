@@ -0,0 +1,172 @@
+#include "FractalKernels.h"
+#include <cstdlib>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRACTAL_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FRACTAL_TARGET_AVX2
+#else
+#define FRACTAL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	int dotScalar(const int16_t* a, const int16_t* b, int n)
+	{
+		int sum = 0;
+		for (int i = 0; i < n; i++) {
+			sum += a[i] * b[i];
+		}
+		return sum;
+	}
+
+	int scaledSadScalar(const int16_t* r, const int16_t* v, int16_t alpha, int n)
+	{
+		int sum = 0;
+		for (int i = 0; i < n; i++) {
+			sum += std::abs(r[i] - ((v[i] * alpha + 0x4000) >> 15));
+		}
+		return sum;
+	}
+
+#ifdef FRACTAL_KERNELS_X86
+	inline int hsum(__m128i v)
+	{
+		v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+		v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(v);
+	}
+
+	int dotSse2(const int16_t* a, const int16_t* b, int n)
+	{
+		__m128i acc = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+			__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+		}
+		return hsum(acc) + dotScalar(a + i, b + i, n - i);
+	}
+
+	int scaledSadSse2(const int16_t* r, const int16_t* v, int16_t alpha, int n)
+	{
+		// v * alpha + 0x4000 as a single madd over interleaved (v, 1) and (alpha, 0x4000) pairs
+		const __m128i coeffs = _mm_set1_epi32((0x4000 << 16) | uint16_t(alpha));
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i zero = _mm_setzero_si128();
+
+		__m128i acc = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m128i vv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+			__m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(vv, one), coeffs), 15);
+			__m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(vv, one), coeffs), 15);
+			__m128i scaled = _mm_packs_epi32(lo, hi);
+
+			__m128i d = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i)), scaled);
+			d = _mm_max_epi16(d, _mm_sub_epi16(zero, d));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(d, one));
+		}
+		return hsum(acc) + scaledSadScalar(r + i, v + i, alpha, n - i);
+	}
+
+	FRACTAL_TARGET_AVX2 int dotAvx2(const int16_t* a, const int16_t* b, int n)
+	{
+		__m256i acc = _mm256_setzero_si256();
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+			__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+		}
+		__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+		return hsum(sum) + dotScalar(a + i, b + i, n - i);
+	}
+
+	FRACTAL_TARGET_AVX2 int scaledSadAvx2(const int16_t* r, const int16_t* v, int16_t alpha, int n)
+	{
+		const __m256i a = _mm256_set1_epi16(alpha);
+		const __m256i one = _mm256_set1_epi16(1);
+
+		__m256i acc = _mm256_setzero_si256();
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			__m256i scaled = _mm256_mulhrs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), a);
+			__m256i d = _mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i)), scaled);
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_abs_epi16(d), one));
+		}
+		__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+		return hsum(sum) + scaledSadScalar(r + i, v + i, alpha, n - i);
+	}
+
+	bool cpuSupportsAvx2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		// OS must save the ymm registers
+		__cpuid(info, 1);
+		bool bOsxsave = (info[2] & (1 << 27)) != 0;
+		if (!bOsxsave || (_xgetbv(0) & 0x6) != 0x6) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	const FractalKernels::Kernels scalarKernels = { FractalKernels::SCALAR, dotScalar, scaledSadScalar };
+#ifdef FRACTAL_KERNELS_X86
+	const FractalKernels::Kernels sse2Kernels = { FractalKernels::SSE2, dotSse2, scaledSadSse2 };
+	const FractalKernels::Kernels avx2Kernels = { FractalKernels::AVX2, dotAvx2, scaledSadAvx2 };
+#endif
+}
+
+FractalKernels::Level FractalKernels::getSupportedLevel()
+{
+#ifdef FRACTAL_KERNELS_X86
+	static const Level level = cpuSupportsAvx2() ? AVX2 : SSE2;
+	return level;
+#else
+	return SCALAR;
+#endif
+}
+
+const FractalKernels::Kernels& FractalKernels::get()
+{
+	return get(getSupportedLevel());
+}
+
+// Falls back to the widest supported level if the requested one is not available
+const FractalKernels::Kernels& FractalKernels::get(Level level)
+{
+	Level supported = getSupportedLevel();
+	if (level > supported) {
+		level = supported;
+	}
+#ifdef FRACTAL_KERNELS_X86
+	if (level == AVX2) return avx2Kernels;
+	if (level == SSE2) return sse2Kernels;
+#endif
+	return scalarKernels;
+}
+
+const char* FractalKernels::getLevelName(Level level)
+{
+	switch (level)
+	{
+	case AVX2: return "avx2";
+	case SSE2: return "sse2";
+	default: return "scalar";
+	}
+}
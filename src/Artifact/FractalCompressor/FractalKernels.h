@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+// Block matching kernels on 16-bit lanes. The widest instruction set the CPU supports is picked once at runtime,
+// every level produces the same results as the scalar fallback.
+class FractalKernels
+{
+public:
+	enum Level { SCALAR, SSE2, AVX2 };
+
+	// Sum of a[i] * b[i]
+	typedef int (*DotFunc)(const int16_t* a, const int16_t* b, int n);
+
+	// Sum of |r[i] - round(v[i] * alpha)| with alpha in Q15 fixed point, rounded half up like _mm_mulhrs_epi16
+	typedef int (*ScaledSadFunc)(const int16_t* r, const int16_t* v, int16_t alpha, int n);
+
+	struct Kernels
+	{
+		Level level;
+		DotFunc dot;
+		ScaledSadFunc scaledSad;
+	};
+
+	static const Kernels& get();
+	static const Kernels& get(Level level);
+
+	static Level getSupportedLevel();
+	static const char* getLevelName(Level level);
+};
@@ -0,0 +1,250 @@
+#include "JpegComplexity.h"
+
+namespace
+{
+	// ITU T.81 Annex K tables
+	const int luminanceQuantTable[64] = {
+		16, 11, 10, 16, 24, 40, 51, 61,
+		12, 12, 14, 19, 26, 58, 60, 55,
+		14, 13, 16, 24, 40, 57, 69, 56,
+		14, 17, 22, 29, 51, 87, 80, 62,
+		18, 22, 37, 56, 68, 109, 103, 77,
+		24, 35, 55, 64, 81, 104, 113, 92,
+		49, 64, 78, 87, 103, 121, 120, 101,
+		72, 92, 95, 98, 112, 100, 103, 99
+	};
+
+	const int zigzag[64] = {
+		0, 1, 8, 16, 9, 2, 3, 10,
+		17, 24, 32, 25, 18, 11, 4, 5,
+		12, 19, 26, 33, 40, 48, 41, 34,
+		27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36,
+		29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46,
+		53, 60, 61, 54, 47, 55, 62, 63
+	};
+
+	// Code lengths 1..16 and symbols of the luminance Huffman tables
+	const uint8_t dcBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+	const uint8_t dcValues[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+	const uint8_t acBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+	const uint8_t acValues[162] = {
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+		0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+		0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+		0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+		0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+		0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+		0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa
+	};
+
+	// SOI, JFIF APP0, DQT, SOF0 and SOS of a single component, the two DHT segments and EOI
+	const size_t markerBytes = 2 + 18 + (5 + 64) + (8 + 3 + 2) + (4 + 2 + 4) + 2;
+
+	// Magnitude category: number of bits of |v|
+	inline int category(int v)
+	{
+		v = std::abs(v);
+		int n = 0;
+		while (v) {
+			n++;
+			v >>= 1;
+		}
+		return n;
+	}
+}
+
+void JpegComplexity::setup(int quality)
+{
+	_quality = std::min(std::max(quality, 1), 100);
+
+	// Quality scaling of jpeg_set_quality, limited to 8-bit tables for baseline
+	int scale = (_quality < 50) ? 5000 / _quality : 200 - _quality * 2;
+	for (int i = 0; i < 64; i++) {
+		_quantTable[i] = std::min(std::max((luminanceQuantTable[i] * scale + 50) / 100, 1), 255);
+	}
+
+	for (int u = 0; u < 8; u++) {
+		float c = (u == 0) ? std::sqrt(1.0f / 8.0f) : std::sqrt(2.0f / 8.0f);
+		for (int x = 0; x < 8; x++) {
+			_dct[u][x] = c * std::cos((2 * x + 1) * u * float(CV_PI) / 16.0f);
+		}
+	}
+
+	buildHuffmanTable(dcBits, dcValues, _dcTable);
+	buildHuffmanTable(acBits, acValues, _acTable);
+	_headerBytes = markerBytes + (5 + 16 + sizeof(dcValues)) + (5 + 16 + sizeof(acValues));
+
+	_bSetup = true;
+}
+
+// Canonical codes from the code length counts (ITU T.81 Annex C)
+void JpegComplexity::buildHuffmanTable(const uint8_t* bits, const uint8_t* values, HuffmanCode* table)
+{
+	uint16_t code = 0;
+	int k = 0;
+	for (int length = 1; length <= 16; length++) {
+		for (int i = 0; i < bits[length - 1]; i++) {
+			table[values[k++]] = { code++, uint8_t(length) };
+		}
+		code <<= 1;
+	}
+}
+
+JpegComplexity::Result JpegComplexity::estimate(const cv::Mat& im, cv::Mat* decoded)
+{
+	if (!_bSetup) {
+		setup(_quality);
+	}
+	if (decoded) {
+		decoded->create(im.rows, im.cols, CV_8UC1);
+	}
+
+	_bitBuffer = 0;
+	_bitCount = 0;
+	_lastDc = 0;
+	_entropyBytes = 0;
+
+	uint64_t squaredError = 0;
+
+	float block[64];
+	float temp[64];
+	int coefficients[64];
+
+	for (int by = 0; by < im.rows; by += 8) {
+		for (int bx = 0; bx < im.cols; bx += 8) {
+
+			// Level shifted samples, edges replicated like the encoder pads partial blocks
+			for (int y = 0; y < 8; y++) {
+				const unsigned char* row = im.ptr<unsigned char>(std::min(by + y, im.rows - 1));
+				for (int x = 0; x < 8; x++) {
+					block[y * 8 + x] = row[std::min(bx + x, im.cols - 1)] - 128.0f;
+				}
+			}
+
+			// Forward transform, rows then columns
+			for (int y = 0; y < 8; y++) {
+				for (int u = 0; u < 8; u++) {
+					float sum = 0.0f;
+					for (int x = 0; x < 8; x++) {
+						sum += _dct[u][x] * block[y * 8 + x];
+					}
+					temp[y * 8 + u] = sum;
+				}
+			}
+			for (int v = 0; v < 8; v++) {
+				for (int u = 0; u < 8; u++) {
+					float sum = 0.0f;
+					for (int y = 0; y < 8; y++) {
+						sum += _dct[v][y] * temp[y * 8 + u];
+					}
+					// Rounded half away from zero, like the integer quantizer of libjpeg
+					float q = sum / _quantTable[v * 8 + u];
+					coefficients[v * 8 + u] = int(q < 0.0f ? q - 0.5f : q + 0.5f);
+				}
+			}
+
+			encodeBlock(coefficients);
+
+			// Dequantize and inverse transform, columns then rows
+			for (int y = 0; y < 8; y++) {
+				for (int u = 0; u < 8; u++) {
+					float sum = 0.0f;
+					for (int v = 0; v < 8; v++) {
+						sum += _dct[v][y] * float(coefficients[v * 8 + u] * _quantTable[v * 8 + u]);
+					}
+					temp[y * 8 + u] = sum;
+				}
+			}
+			const int rows = std::min(8, im.rows - by);
+			const int cols = std::min(8, im.cols - bx);
+			for (int y = 0; y < rows; y++) {
+				const unsigned char* src = im.ptr<unsigned char>(by + y) + bx;
+				unsigned char* dst = decoded ? decoded->ptr<unsigned char>(by + y) + bx : nullptr;
+				for (int x = 0; x < cols; x++) {
+					float sum = 0.0f;
+					for (int u = 0; u < 8; u++) {
+						sum += _dct[u][x] * temp[y * 8 + u];
+					}
+					int value = std::min(std::max(int(std::floor(sum + 128.5f)), 0), 255);
+					int error = value - src[x];
+					squaredError += error * error;
+					if (dst) {
+						dst[x] = value;
+					}
+				}
+			}
+		}
+	}
+	flushBits();
+
+	Result result;
+	result.bytes = _headerBytes + _entropyBytes;
+	result.rmse = im.total() ? std::sqrt(double(squaredError) / im.total()) : 0.0;
+	return result;
+}
+
+void JpegComplexity::encodeBlock(const int* coefficients)
+{
+	int diff = coefficients[0] - _lastDc;
+	_lastDc = coefficients[0];
+
+	// Negative values are sent as the low bits of v - 1
+	int size = category(diff);
+	putBits(_dcTable[size].code, _dcTable[size].length);
+	if (size) {
+		putBits(diff < 0 ? diff - 1 : diff, size);
+	}
+
+	int run = 0;
+	for (int k = 1; k < 64; k++) {
+		int v = coefficients[zigzag[k]];
+		if (v == 0) {
+			run++;
+			continue;
+		}
+		while (run > 15) {
+			putBits(_acTable[0xF0].code, _acTable[0xF0].length);
+			run -= 16;
+		}
+		size = category(v);
+		const HuffmanCode& code = _acTable[(run << 4) | size];
+		putBits(code.code, code.length);
+		putBits(v < 0 ? v - 1 : v, size);
+		run = 0;
+	}
+	if (run > 0) {
+		putBits(_acTable[0x00].code, _acTable[0x00].length);
+	}
+}
+
+// Only the number of bytes is kept, including the zero stuffed after every 0xFF
+void JpegComplexity::putBits(uint32_t bits, int length)
+{
+	_bitBuffer = (_bitBuffer << length) | (bits & ((1u << length) - 1));
+	_bitCount += length;
+	while (_bitCount >= 8) {
+		_bitCount -= 8;
+		uint32_t byte = (_bitBuffer >> _bitCount) & 0xFF;
+		_entropyBytes += (byte == 0xFF) ? 2 : 1;
+	}
+}
+
+// Pads the last byte with ones
+void JpegComplexity::flushBits()
+{
+	putBits(0x7F, 7);
+	_bitBuffer = 0;
+	_bitCount = 0;
+}
+
+int JpegComplexity::getQuality() const
+{
+	return _quality;
+}
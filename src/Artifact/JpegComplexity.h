@@ -0,0 +1,57 @@
+#pragma once
+#include "ofxOpenCv.h"
+
+// Baseline JPEG compression of a grayscale image, measured in-process instead of through an image codec and file
+// buffer. Every 8x8 block is transformed, quantized with the standard luminance table at the given quality and
+// entropy coded with the standard Huffman tables to count the bytes a baseline JFIF encoder writes, then dequantized
+// and transformed back to measure the error of the decoded image, all in a single pass over the blocks.
+// Tables are built once in setup; estimating allocates nothing unless a decoded image of a new size is requested.
+class JpegComplexity
+{
+public:
+	struct Result
+	{
+		size_t bytes;	// file size, headers included
+		double rmse;	// root mean square error of the decoded image
+	};
+
+	// Quality [1..100] as passed to jpeg_set_quality (OF_IMAGE_QUALITY_HIGH is 75)
+	void setup(int quality = 75);
+
+	// im must be CV_8UC1. If decoded is given, it receives the decoded image
+	Result estimate(const cv::Mat& im, cv::Mat* decoded = nullptr);
+
+	int getQuality() const;
+
+private:
+	struct HuffmanCode
+	{
+		uint16_t code;
+		uint8_t length;
+	};
+
+	void buildHuffmanTable(const uint8_t* bits, const uint8_t* values, HuffmanCode* table);
+
+	void encodeBlock(const int* coefficients);
+	void putBits(uint32_t bits, int length);
+	void flushBits();
+
+	// Orthonormal DCT-II basis, _dct[u][x]
+	float _dct[8][8];
+
+	// Quantization divisors in natural order
+	int _quantTable[64];
+
+	HuffmanCode _dcTable[12];
+	HuffmanCode _acTable[256];
+
+	// Entropy coder state of the current image
+	uint32_t _bitBuffer = 0;
+	int _bitCount = 0;
+	int _lastDc = 0;
+	size_t _entropyBytes = 0;
+
+	size_t _headerBytes = 0;
+	int _quality = 75;
+	bool _bSetup = false;
+};
@@ -0,0 +1,153 @@
+#include "MaskCoverageEvaluator.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MASK_COVERAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+MaskCoverageEvaluator::MaskCoverageEvaluator(std::string maskFile) :
+	_maskFile(maskFile)
+{}
+
+void MaskCoverageEvaluator::setup(uint32_t width, uint32_t height)
+{
+	cv::Mat mask;
+	if (!_maskFile.empty()) {
+		mask = cv::imread(ofToDataPath(_maskFile), cv::IMREAD_GRAYSCALE);
+		if (mask.empty()) {
+			ofLogError() << "[MaskCoverageEvaluator] Could not load " << _maskFile << ", using the default mask";
+		}
+		else if (mask.cols != int(width) || mask.rows != int(height)) {
+			cv::resize(mask, mask, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+		}
+	}
+	if (mask.empty()) {
+		mask = createMask(width, height);
+	}
+	setMask(mask);
+}
+
+cv::Mat MaskCoverageEvaluator::createMask(uint32_t width, uint32_t height)
+{
+	cv::Mat mask(height, width, CV_8UC1, cv::Scalar(0));
+	cv::circle(mask, cv::Point(width / 2, height / 2), width / 4, cv::Scalar(255), cv::FILLED);
+	return mask;
+}
+
+cv::Mat InverseCircleCoverageEvaluator::createMask(uint32_t width, uint32_t height)
+{
+	cv::Mat mask;
+	cv::bitwise_not(MaskCoverageEvaluator::createMask(width, height), mask);
+	return mask;
+}
+
+void MaskCoverageEvaluator::setMask(const cv::Mat& mask)
+{
+	_mask = mask.clone();
+
+	_rewardWeights.resize(_mask.total());
+	_penaltyWeights.resize(_mask.total());
+	_rewardWeightSum = 0;
+	_penaltyWeightSum = 0;
+
+	for (int i = 0; i < _mask.rows; i++) {
+		const uint8_t* row = _mask.ptr<uint8_t>(i);
+		for (int j = 0; j < _mask.cols; j++) {
+			int w = 2 * row[j] - 255;
+			int k = i * _mask.cols + j;
+			_rewardWeights[k] = std::max(w, 0);
+			_penaltyWeights[k] = std::max(-w, 0);
+			_rewardWeightSum += _rewardWeights[k];
+			_penaltyWeightSum += _penaltyWeights[k];
+		}
+	}
+}
+
+const cv::Mat& MaskCoverageEvaluator::getMask() const
+{
+	return _mask;
+}
+
+// Sums of the pixels and of the pixels times both weight masks in one pass. Products are accumulated per row in 32-bit
+// lanes, which gain at most 4 * 255 * 255 per 16 pixels and cannot overflow on any practical canvas
+MaskCoverageEvaluator::Sums MaskCoverageEvaluator::accumulate(const cv::Mat& im) const
+{
+	Sums sums = { 0, 0, 0 };
+
+	for (int i = 0; i < im.rows; i++) {
+		const uint8_t* p = im.ptr<uint8_t>(i);
+		const int16_t* rw = &_rewardWeights[i * im.cols];
+		const int16_t* pw = &_penaltyWeights[i * im.cols];
+
+		int j = 0;
+#ifdef MASK_COVERAGE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		__m128i total = _mm_setzero_si128();
+		__m128i reward = _mm_setzero_si128();
+		__m128i penalty = _mm_setzero_si128();
+
+		for (; j + 16 <= im.cols; j += 16) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j));
+			__m128i lo = _mm_unpacklo_epi8(v, zero);
+			__m128i hi = _mm_unpackhi_epi8(v, zero);
+
+			total = _mm_add_epi64(total, _mm_sad_epu8(v, zero));
+			reward = _mm_add_epi32(reward, _mm_madd_epi16(lo, _mm_loadu_si128(reinterpret_cast<const __m128i*>(rw + j))));
+			reward = _mm_add_epi32(reward, _mm_madd_epi16(hi, _mm_loadu_si128(reinterpret_cast<const __m128i*>(rw + j + 8))));
+			penalty = _mm_add_epi32(penalty, _mm_madd_epi16(lo, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pw + j))));
+			penalty = _mm_add_epi32(penalty, _mm_madd_epi16(hi, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pw + j + 8))));
+		}
+
+		alignas(16) uint64_t total64[2];
+		alignas(16) uint32_t reward32[4];
+		alignas(16) uint32_t penalty32[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(total64), total);
+		_mm_store_si128(reinterpret_cast<__m128i*>(reward32), reward);
+		_mm_store_si128(reinterpret_cast<__m128i*>(penalty32), penalty);
+
+		sums.total += total64[0] + total64[1];
+		sums.reward += uint64_t(reward32[0]) + reward32[1] + reward32[2] + reward32[3];
+		sums.penalty += uint64_t(penalty32[0]) + penalty32[1] + penalty32[2] + penalty32[3];
+#endif
+		for (; j < im.cols; j++) {
+			sums.total += p[j];
+			sums.reward += p[j] * rw[j];
+			sums.penalty += p[j] * pw[j];
+		}
+	}
+	return sums;
+}
+
+std::vector<double> MaskCoverageEvaluator::evaluate(cv::Mat im)
+{
+	if (im.elemSize() != 1) {
+		ofLog() << "[Evaluator] Warning: elemSize of im is not equal to 1.";
+	}
+	if (im.rows != _mask.rows || im.cols != _mask.cols) {
+		ofLog() << "[MaskCoverageEvaluator] Warning: resizing the mask to the artifact.";
+		cv::Mat mask;
+		cv::resize(_mask, mask, cv::Size(im.cols, im.rows), 0, 0, cv::INTER_AREA);
+		setMask(mask);
+	}
+
+	Sums sums = accumulate(im);
+
+	// Weights are [0..255] for [0..1]
+	double maxReward = 255.0 * _rewardWeightSum;
+	double fitness = maxReward > 0.0 ? (double(sums.reward) - double(sums.penalty)) / maxReward : 0.0;
+	double coverage = im.total() ? sums.total / (255.0 * im.total()) : 0.0;
+	double reward = maxReward > 0.0 ? sums.reward / maxReward : 0.0;
+	double penalty = _penaltyWeightSum ? sums.penalty / (255.0 * _penaltyWeightSum) : 0.0;
+
+	char msg[256];
+	sprintf(msg, "Artifact Evaluation Report:\nfitness: %f; coverage: %f; reward: %f; penalty: %f\n", fitness, coverage, reward, penalty);
+	ofLog() << msg;
+
+	std::vector<double> results(4);
+	results[0] = fitness;
+	results[1] = coverage;
+	results[2] = reward;
+	results[3] = penalty;
+
+	return results;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Artifact/EvaluatorBase.h"
+#include "ofxOpenCv.h"
+
+// Rewards paint inside a target mask and penalizes paint outside of it. Mask pixels map to signed weights
+// (2v - 255) / 255: white rewards, black penalizes and mid gray is neutral, so binary masks behave like the original
+// bitwise_and evaluators. The weights are split into a reward and a penalty mask once, evaluation is a single fused
+// multiply-accumulate pass over the artifact that also yields the coverage.
+//
+// Results: [fitness, coverage, reward, penalty]
+//   fitness:  (reward sum - penalty sum) / maximum reward sum
+//   coverage: mean intensity of the artifact [0..1]
+//   reward:   share of the reward region that is painted [0..1]
+//   penalty:  share of the penalty region that is painted [0..1]
+class MaskCoverageEvaluator : public EvaluatorBase
+{
+public:
+	// maskFile: grayscale target image, resized to the canvas. Without one the mask of createMask() is used
+	MaskCoverageEvaluator(std::string maskFile = "");
+
+	virtual void setup(uint32_t width, uint32_t height) override;
+	virtual std::vector<double> evaluate(cv::Mat im) override;
+
+	void setMask(const cv::Mat& mask);
+	const cv::Mat& getMask() const;
+
+protected:
+	// Filled circle with a quarter of the canvas width as radius
+	virtual cv::Mat createMask(uint32_t width, uint32_t height);
+
+private:
+	struct Sums
+	{
+		uint64_t total;
+		uint64_t reward;
+		uint64_t penalty;
+	};
+
+	Sums accumulate(const cv::Mat& im) const;
+
+	std::string _maskFile;
+	cv::Mat _mask;
+
+	// Per-pixel weights [0..255] in row-major order
+	std::vector<int16_t> _rewardWeights;
+	std::vector<int16_t> _penaltyWeights;
+
+	uint64_t _rewardWeightSum = 0;
+	uint64_t _penaltyWeightSum = 0;
+};
+
+class CircleCoverageEvaluator : public MaskCoverageEvaluator
+{
+};
+
+class InverseCircleCoverageEvaluator : public MaskCoverageEvaluator
+{
+protected:
+	virtual cv::Mat createMask(uint32_t width, uint32_t height) override;
+};
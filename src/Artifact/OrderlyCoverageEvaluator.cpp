@@ -1,14 +1,21 @@
 #include "OrderlyCoverageEvaluator.h"
-#include "Artifact/QuadtreeCompressor/qtree.hpp"
 #include "Utils/MathUtils.h"
 
 void OrderlyCoverageEvaluator::setup(uint32_t width, uint32_t height)
 {
 	_maxCoverageReward = width * height * 255.0;
+	_quadtree.setup(_quadtreeThreshold);
 }
 
 std::vector<double> OrderlyCoverageEvaluator::evaluate(cv::Mat im)
 {
+	_context.reset(im);
+	return evaluate(_context);
+}
+
+std::vector<double> OrderlyCoverageEvaluator::evaluate(FeatureContext& context)
+{
+	const cv::Mat& im = context.getImage();
 	if (im.elemSize() != 1) {
 		ofLog() << "[Evaluator] Warning: elemSize of im is not equal to 1.";
 	}
@@ -17,47 +24,27 @@ std::vector<double> OrderlyCoverageEvaluator::evaluate(cv::Mat im)
 	}
 
 	// Coverage measure
-	double coverage = cv::mean(im)[0] / 255.0;
+	double coverage = context.getCoverage();
 	_latestCoverageScore = coverage;
 
 	double imageComplexity = coverageFunc(coverage);
 
-	// Lower contrast to improve the reliability of the fractal compression algorithm (alpha[1.0-3.0], beta[0-100])
-	cv::Mat src;
-	cv::Mat blur;
-
-	cv::blur(im, blur, cv::Size(9, 9));
-	blur.convertTo(src, CV_8UC1);
-
 	// Quadtree Complexity
-	int* pixels = new int[src.rows * src.cols];
-	for (int r = 0; r < src.rows; r++) {
-		for (int c = 0; c < src.cols; c++) {
-			pixels[r * src.cols + c] = src.at<uint8_t>(r, c);
-		}
-	}
-	qt_node* q = init_node();
-	add_values(q, pixels, src.rows, src.cols);
-
-	// 0 = very little compression, 20 = a lot of compression
-	build_tree(q, 20);
+	// Built on the 9px blur memoized in the FeatureContext, so a Composite objective sharing the context blurs only once
+	_quadtree.build(context.getBlur(9));
 
-	ofLog() << "Nodes: " << count_tree_nodes(q) << endl;
-	ofLog() << "Pixel check: " << check_num_pixels(q) << endl;
-
-	cv::Mat im_unpacked = cv::Mat(src.rows, src.cols, CV_8UC1);
-
-	unpack_tree(q, im_unpacked, src.rows, src.cols);
-	cv::imwrite("data/keep/compressed.bmp", im_unpacked);
-	delete[] pixels;
+	if (_bWriteToDisk) {
+		_quadtree.unpack(_unpacked);
+		cv::imwrite("data/keep/compressed.bmp", _unpacked);
+	}
 
-	double numNodes = count_tree_nodes(q);
-	double numPixels = check_num_pixels(q);
+	double numNodes = _quadtree.getNumNodes();
+	double numPixels = _quadtree.getNumPixels();
 	double processingComplexity = (numPixels - numNodes) / numPixels;
 
 	double fitness = imageComplexity / processingComplexity;
 
-	ofLog() << "numPixels: " << numPixels << " , numNodes: " << numNodes;
+	ofLog() << "numPixels: " << numPixels << " , numNodes: " << numNodes << " , depth: " << _quadtree.getDepth();
 	ofLog() << "ic: " << imageComplexity << " , pc: " << processingComplexity << " , f: " << fitness;
 
 	std::vector<double> result(1);
@@ -83,3 +70,8 @@ void OrderlyCoverageEvaluator::setDecodingDepth(int depth)
 {
 	_decodingDepth = depth;
 }
+
+void OrderlyCoverageEvaluator::setWriteToDisk(bool enable)
+{
+	_bWriteToDisk = enable;
+}
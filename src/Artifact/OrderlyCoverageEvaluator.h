@@ -1,6 +1,6 @@
 #pragma once
 #include "Artifact/EvaluatorBase.h"
-#include "Artifact/FractalCompressor/FractalCompressor.h"
+#include "Artifact/QuadtreeCompressor/QuadtreeCompressor.h"
 #include "ofxOpenCv.h"
 
 class OrderlyCoverageEvaluator : public EvaluatorBase
@@ -8,13 +8,26 @@ class OrderlyCoverageEvaluator : public EvaluatorBase
 public:
 	virtual void setup(uint32_t width, uint32_t height) override;
 	virtual std::vector<double> evaluate(cv::Mat im) override;
+	virtual std::vector<double> evaluate(FeatureContext& context) override;
 
 	double getLatestCoverageScore();
 	void setDecodingDepth(int depth);
 
+	// The unpacked quadtree of every evaluation goes to data/keep/compressed.bmp, so only one evaluator may write it
+	void setWriteToDisk(bool enable);
+
 private:
 	double coverageFunc(double coverage);
 
+	QuadtreeCompressor _quadtree;
+
+	// Intermediates of standalone evaluations and unpacked quadtree, reused across evaluations
+	FeatureContext _context;
+	cv::Mat _unpacked;
+
+	// Standard deviation above which a quadtree node is split (0: very little compression, 20: a lot of compression)
+	double _quadtreeThreshold = 20.0;
+
 	int _decodingDepth = 3;
 
 	double _maxCoverageReward;
@@ -26,4 +39,6 @@ private:
 	double pc0LowerBound = 1.0;
 	double pc1Lowerbound = 1.0;
 	double icUpperBound = 20.0;
+
+	bool _bWriteToDisk = false;
 };
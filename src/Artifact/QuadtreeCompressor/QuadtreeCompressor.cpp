@@ -0,0 +1,137 @@
+#include "QuadtreeCompressor.h"
+
+void QuadtreeCompressor::setup(double threshold, int minNodeSize)
+{
+	_threshold = threshold;
+	_minNodeSize = std::max(minNodeSize, 1);
+}
+
+void QuadtreeCompressor::buildTables(const cv::Mat& im)
+{
+	_width = im.cols;
+	_height = im.rows;
+
+	const int stride = _width + 1;
+	_sum.assign(stride * (_height + 1), 0);
+	_sumSq.assign(stride * (_height + 1), 0);
+
+	for (int y = 0; y < _height; y++) {
+		const uint8_t* row = im.ptr<uint8_t>(y);
+		uint32_t rowSum = 0;
+		uint64_t rowSumSq = 0;
+		for (int x = 0; x < _width; x++) {
+			rowSum += row[x];
+			rowSumSq += row[x] * row[x];
+			_sum[(y + 1) * stride + x + 1] = _sum[y * stride + x + 1] + rowSum;
+			_sumSq[(y + 1) * stride + x + 1] = _sumSq[y * stride + x + 1] + rowSumSq;
+		}
+	}
+}
+
+// Compares the variance against threshold^2 in integers: n * sum(p^2) - sum(p)^2 > (threshold * n)^2
+bool QuadtreeCompressor::shouldSplit(const Node& node, uint8_t& mean) const
+{
+	const int stride = _width + 1;
+	const int a = node.y * stride + node.x;
+	const int b = a + node.width;
+	const int c = a + node.height * stride;
+	const int d = c + node.width;
+
+	const int64_t n = int64_t(node.width) * node.height;
+
+	// Box sums are exact in modular arithmetic even if the table wraps
+	const int64_t sum = uint32_t(_sum[d] - _sum[b] - _sum[c] + _sum[a]);
+	const int64_t sumSq = int64_t(_sumSq[d] - _sumSq[b] - _sumSq[c] + _sumSq[a]);
+
+	mean = uint8_t((sum + n / 2) / n);
+
+	if (node.width <= _minNodeSize && node.height <= _minNodeSize) {
+		return false;
+	}
+	const double limit = _threshold * n;
+	return double(n * sumSq - sum * sum) > limit * limit;
+}
+
+void QuadtreeCompressor::build(const cv::Mat& im)
+{
+	buildTables(im);
+
+	_nodes.clear();
+	_numLeaves = 0;
+	_depth = 0;
+	if (_width == 0 || _height == 0) {
+		return;
+	}
+	_nodes.push_back({ 0, 0, _width, _height, -1, 0, 0 });
+
+	// Breadth-first, the node array doubles as the queue. Levels end where the previous level's children end
+	size_t levelEnd = 1;
+	for (size_t i = 0; i < _nodes.size(); i++) {
+		if (i == levelEnd) {
+			levelEnd = _nodes.size();
+			_depth++;
+		}
+
+		uint8_t mean;
+		if (!shouldSplit(_nodes[i], mean)) {
+			_nodes[i].mean = mean;
+			_numLeaves++;
+			continue;
+		}
+		const Node node = _nodes[i];
+		const int w0 = node.width / 2;
+		const int h0 = node.height / 2;
+
+		// Odd sizes give the extra row/column to the second half, degenerate quadrants are skipped
+		const int xs[2] = { node.x, node.x + w0 };
+		const int ys[2] = { node.y, node.y + h0 };
+		const int ws[2] = { w0, node.width - w0 };
+		const int hs[2] = { h0, node.height - h0 };
+
+		_nodes[i].mean = mean;
+		_nodes[i].firstChild = int(_nodes.size());
+		for (int qy = 0; qy < 2; qy++) {
+			for (int qx = 0; qx < 2; qx++) {
+				if (ws[qx] > 0 && hs[qy] > 0) {
+					_nodes.push_back({ xs[qx], ys[qy], ws[qx], hs[qy], -1, 0, 0 });
+				}
+			}
+		}
+		_nodes[i].numChildren = int(_nodes.size()) - _nodes[i].firstChild;
+	}
+}
+
+void QuadtreeCompressor::unpack(cv::Mat& out) const
+{
+	out.create(_height, _width, CV_8UC1);
+	for (const Node& node : _nodes) {
+		if (node.firstChild < 0) {
+			out(cv::Rect(node.x, node.y, node.width, node.height)).setTo(cv::Scalar(node.mean));
+		}
+	}
+}
+
+size_t QuadtreeCompressor::getNumNodes() const
+{
+	return _nodes.size();
+}
+
+size_t QuadtreeCompressor::getNumLeaves() const
+{
+	return _numLeaves;
+}
+
+size_t QuadtreeCompressor::getNumPixels() const
+{
+	return size_t(_width) * _height;
+}
+
+int QuadtreeCompressor::getDepth() const
+{
+	return _depth;
+}
+
+const std::vector<QuadtreeCompressor::Node>& QuadtreeCompressor::getNodes() const
+{
+	return _nodes;
+}
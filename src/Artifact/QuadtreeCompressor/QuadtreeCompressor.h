@@ -0,0 +1,55 @@
+#pragma once
+#include "ofxOpenCv.h"
+
+// Quadtree compression of a grayscale image, used as a measure of how orderly an artifact is. A node is split into
+// (up to) four quadrants while the standard deviation of its pixels exceeds the threshold, leaves store their mean.
+// Split decisions read a summed-area table of the pixels and of their squares, so each node costs O(1) regardless of
+// its size. Nodes live in a flat array in breadth-first order, the children of a node are stored contiguously.
+// Tables and nodes are reused across images.
+class QuadtreeCompressor
+{
+public:
+	struct Node
+	{
+		int x;
+		int y;
+		int width;
+		int height;
+		int firstChild;		// -1 for leaves
+		int numChildren;
+		uint8_t mean;
+	};
+
+	// threshold: standard deviation of a node above which it is split (0: only uniform nodes are leaves)
+	void setup(double threshold = 20.0, int minNodeSize = 1);
+
+	// im must be CV_8UC1
+	void build(const cv::Mat& im);
+
+	// Every leaf filled with its mean
+	void unpack(cv::Mat& out) const;
+
+	size_t getNumNodes() const;
+	size_t getNumLeaves() const;
+	size_t getNumPixels() const;
+	int getDepth() const;
+	const std::vector<Node>& getNodes() const;
+
+private:
+	void buildTables(const cv::Mat& im);
+	bool shouldSplit(const Node& node, uint8_t& mean) const;
+
+	// (width + 1) x (height + 1) with a zero first row and column
+	std::vector<uint32_t> _sum;
+	std::vector<uint64_t> _sumSq;
+
+	std::vector<Node> _nodes;
+
+	double _threshold = 20.0;
+	int _minNodeSize = 1;
+
+	int _width = 0;
+	int _height = 0;
+	size_t _numLeaves = 0;
+	int _depth = 0;
+};
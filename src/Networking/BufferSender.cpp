@@ -22,18 +22,22 @@ void BufferSender::allocate(uint32_t w, uint32_t h, ofPixelFormat type)
     memset(&_prefs, 0, sizeof(_prefs));
     _prefs.frameInfo = info;
 
-    _compressBound = LZ4F_compressFrameBound(_bufSize, &_prefs);
+    // Large enough for a frame or a stream block and its header
+    _compressBound = std::max(LZ4F_compressFrameBound(_bufSize, &_prefs), size_t(LZ4_compressBound(_bufSize)) + OSC_PATCH_HEADER_SIZE);
+    _streams.clear();
 
     for (int i = 0; i < 2; i++) {
         _pixelBuffer[i].allocate(_width, _height, _pixelFormat);
-        _pixelBufferObject[i].allocate(_bufSize, GL_DYNAMIC_DRAW);
-        _writeBuffer[i].allocate(_compressBound);
     }
     swapBuffers();
 }
 
 void BufferSender::writeToPixels(const ofTexture& tex)
 {
+    // PBOs are only needed for texture readback, so nodes without a GL context never allocate them
+    if (!_pixBufObjectPtr->isAllocated()) {
+        _pixBufObjectPtr->allocate(_bufSize, GL_DYNAMIC_DRAW);
+    }
     tex.copyTo(*_pixBufObjectPtr);
 
     _pixBufObjectPtr->bind(GL_PIXEL_UNPACK_BUFFER);
@@ -44,28 +48,139 @@ void BufferSender::writeToPixels(const ofTexture& tex)
     _pixBufObjectPtr->unbind(GL_PIXEL_UNPACK_BUFFER);
 }
 
+void BufferSender::setStreamMode(bool enable, uint32_t keyframeInterval)
+{
+    _bStreamMode = enable;
+    _keyframeInterval = std::max(keyframeInterval, 1u);
+    _streams.clear();
+
+    if (_bStreamMode) {
+        LZ4_initStream(&_lz4Stream, sizeof(_lz4Stream));
+    }
+}
+
+bool BufferSender::isStreamMode() const
+{
+    return _bStreamMode;
+}
+
+void BufferSender::resetStream(uint32_t id)
+{
+    auto it = _streams.find(id);
+    if (it != _streams.end()) {
+        it->second.previous.clear();
+    }
+}
+
+size_t BufferSender::getPatchBound() const
+{
+    return size_t(LZ4_compressBound(int(_bufSize)));
+}
+
+size_t BufferSender::encodePatch(const uint8_t* bytes, uint32_t id, char* dst, bool& bKeyframe)
+{
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    PatchStream& stream = _streams[id];
+    bKeyframe = stream.previous.size() != _bufSize || stream.numSinceKeyframe >= _keyframeInterval;
+
+    // The local view moves with the brush, so a patch mostly repeats shifted regions of the previous one. Matches
+    // against the previous patch find those, an XOR residual against it would only help when the brush stands still
+    if (bKeyframe) {
+        LZ4_resetStream_fast(&_lz4Stream);
+    }
+    else {
+        // resets the stream as well
+        LZ4_loadDict(&_lz4Stream, (const char*)stream.previous.data(), int(_bufSize));
+    }
+    int compSize = LZ4_compress_fast_continue(&_lz4Stream, (const char*)bytes, dst, int(_bufSize), int(getPatchBound()), 1);
+
+    if (compSize <= 0) {
+        ofLogError() << "Could not compress patch of agent " << id;
+        return 0;
+    }
+    stream.previous.assign(bytes, bytes + _bufSize);
+    stream.numSinceKeyframe = bKeyframe ? 1 : stream.numSinceKeyframe + 1;
+
+    if (bKeyframe) {
+        _numKeyframes++;
+    }
+    else {
+        _numDeltaFrames++;
+    }
+    _rawBytes += _bufSize;
+    _sentBytes += compSize;
+    _encodeMicros += ofGetElapsedTimeMicros() - start;
+
+    return size_t(compSize);
+}
+
+void BufferSender::sendStream(const uint8_t* bytes, uint32_t id)
+{
+    // Every patch goes out in a buffer of its own, a delta that is overwritten before it is sent would break the
+    // stream of its agent until the next keyframe
+    bool bKeyframe;
+    std::vector<char> dst = _senderThread.acquireBuffer(_compressBound);
+    size_t compSize = encodePatch(bytes, id, dst.data() + OSC_PATCH_HEADER_SIZE, bKeyframe);
+    if (compSize == 0) {
+        return;
+    }
+    dst[0] = bKeyframe ? OSC_PATCH_KEYFRAME : OSC_PATCH_DELTA;
+    _sentBytes += OSC_PATCH_HEADER_SIZE;
+
+    _senderThread.send(std::move(dst), compSize + OSC_PATCH_HEADER_SIZE, id, BufferSenderThread::PATCHES);
+}
+
 void BufferSender::send(const uint8_t* bytes, uint32_t id)
 {
+    if (_bStreamMode) {
+        sendStream(bytes, id);
+        return;
+    }
+
     uint64_t start = ofGetElapsedTimeMicros();
-    size_t compSize = LZ4F_compressFrame(_writeBufPtr->getData(), _compressBound, bytes, _bufSize, &_prefs);
+    std::vector<char> dst = _senderThread.acquireBuffer(_compressBound);
+    size_t compSize = LZ4F_compressFrame(dst.data(), _compressBound, bytes, _bufSize, &_prefs);
     uint64_t total = ofGetElapsedTimeMicros() - start;
 
     bool bError = LZ4F_isError(compSize);
     //ofLog() << ((bError) ? LZ4F_getErrorName(compSize) : ofToString(ofToString(total) + "us"));
 
     // compression successful
+    size_t procSize = 0;
     if (!bError || compSize < _bufSize) {
-        _senderThread.setProcSize(compSize);
+        procSize = compSize;
     }
+    _rawBytes += _bufSize;
+    _sentBytes += (procSize > 0) ? procSize : _compressBound;
+    _encodeMicros += total;
+    _numKeyframes++;
+
     //else {
     //    // compression failed. send full size buffer instead (not recommended)
-    //    memcpy(_writeBufPtr->getData(), bytes, _bufSize);
-    //    _senderThread.setProcSize(_bufSize);
+    //    memcpy(dst.data(), bytes, _bufSize);
+    //    procSize = _bufSize;
     //}
-    _senderThread.setId(id);
-    _senderThread.send(_writeBufPtr);
+    _senderThread.send(std::move(dst), (procSize > 0) ? procSize : _compressBound, id);
+}
 
-    swapBuffers();
+void BufferSender::sendBatch(const uint8_t* bytes, size_t size, uint32_t seq)
+{
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.frameType = LZ4F_frame;
+    prefs.frameInfo.contentSize = size;
+
+    // Compressed straight into a buffer the job owns, batches can be flushed faster than they are sent
+    size_t bound = LZ4F_compressFrameBound(size, &prefs);
+    std::vector<char> writeBuf = _senderThread.acquireBuffer(bound);
+
+    size_t compSize = LZ4F_compressFrame(writeBuf.data(), bound, bytes, size, &prefs);
+    if (LZ4F_isError(compSize)) {
+        ofLogError() << "Could not compress observation batch: " << LZ4F_getErrorName(compSize);
+        return;
+    }
+    _senderThread.send(std::move(writeBuf), compSize, seq, BufferSenderThread::OBSERVATIONS);
 }
 
 void BufferSender::send(const ofPixels& pixels, uint32_t id)
@@ -77,6 +192,9 @@ void BufferSender::send(const ofTexture& texture, uint32_t id)
 {
     writeToPixels(texture);
     send(*_pixBufPtr, id);
+
+    // Only the readback buffers alternate, compressed bytes are owned by the sender thread's jobs
+    swapBuffers();
 }
 
 void BufferSender::swapBuffers()
@@ -84,6 +202,26 @@ void BufferSender::swapBuffers()
     _iPBO = (_iPBO + 1) % 2;
 
     _pixBufPtr = &_pixelBuffer[_iPBO];
-    _writeBufPtr = &_writeBuffer[_iPBO];
     _pixBufObjectPtr = &_pixelBufferObject[_iPBO];
 }
+
+double BufferSender::getCompressionRatio() const
+{
+    return _sentBytes ? double(_rawBytes) / _sentBytes : 0.0;
+}
+
+double BufferSender::getAverageEncodeMicros() const
+{
+    uint64_t numPatches = _numKeyframes + _numDeltaFrames;
+    return numPatches ? double(_encodeMicros) / numPatches : 0.0;
+}
+
+uint64_t BufferSender::getNumKeyframes() const
+{
+    return _numKeyframes;
+}
+
+uint64_t BufferSender::getNumDeltaFrames() const
+{
+    return _numDeltaFrames;
+}
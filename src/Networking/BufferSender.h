@@ -4,6 +4,7 @@
 #include "ofImage.h"
 #include "lz4frame.h"
 #include "lz4.h"
+#include <unordered_map>
 
 class BufferSender
 {
@@ -11,11 +12,40 @@ public:
 	void setup(std::string host, int outport);
 	void allocate(uint32_t w, uint32_t h, ofPixelFormat type);
 
+	// Stream mode sends each patch as an LZ4 block that uses the previous patch of the same id as dictionary, with a
+	// keyframe every keyframeInterval patches (see OscProtocol.h). Off: every patch is a standalone LZ4 frame
+	void setStreamMode(bool enable, uint32_t keyframeInterval = 30);
+	bool isStreamMode() const;
+
+	// The next patch of id is sent as a keyframe, call when the receiver starts over with an id
+	void resetStream(uint32_t id);
+
+	// Compresses a patch of id into dst as a stream mode LZ4 block without sending it, returns its size or 0 on error.
+	// bKeyframe tells whether the block was compressed without dictionary. dst must hold getPatchBound bytes
+	size_t encodePatch(const uint8_t* bytes, uint32_t id, char* dst, bool& bKeyframe);
+	size_t getPatchBound() const;
+
 	void send(const uint8_t* bytes, uint32_t id);
 	void send(const ofPixels& pixels, uint32_t id);
 	void send(const ofTexture& texture, uint32_t id);
 
+	// Compresses size bytes into a single frame and sends it as observation batch number seq
+	void sendBatch(const uint8_t* bytes, size_t size, uint32_t seq);
+
+	// Patch bytes before and after compression, headers included, over every patch sent so far
+	double getCompressionRatio() const;
+	double getAverageEncodeMicros() const;
+	uint64_t getNumKeyframes() const;
+	uint64_t getNumDeltaFrames() const;
+
 private:
+	struct PatchStream
+	{
+		std::vector<uint8_t> previous;
+		uint32_t numSinceKeyframe = 0;
+	};
+
+	void sendStream(const uint8_t* bytes, uint32_t id);
 	void writeToPixels(const ofTexture& tex);
 	void swapBuffers();
 
@@ -24,14 +54,25 @@ private:
 
 	ofPixels* _pixBufPtr;
 	ofBufferObject* _pixBufObjectPtr;
-	ofBuffer* _writeBufPtr;
 
 	ofPixels _pixelBuffer[2];
 	ofBufferObject _pixelBufferObject[2];
-	ofBuffer _writeBuffer[2];
 
 	uint32_t _iPBO;
 
+	// stream mode, a single LZ4 stream is reset for every block and given the previous patch of its id
+	bool _bStreamMode = false;
+	uint32_t _keyframeInterval = 30;
+	std::unordered_map<uint32_t, PatchStream> _streams;
+	LZ4_stream_t _lz4Stream;
+
+	// stats
+	uint64_t _rawBytes = 0;
+	uint64_t _sentBytes = 0;
+	uint64_t _encodeMicros = 0;
+	uint64_t _numKeyframes = 0;
+	uint64_t _numDeltaFrames = 0;
+
 	ofPixelFormat _pixelFormat = OF_PIXELS_GRAY;
 	uint32_t _width = 0;
 	uint32_t _height = 0;
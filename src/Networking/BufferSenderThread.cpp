@@ -10,6 +10,7 @@ BufferSenderThread::~BufferSenderThread()
 {
 	channel.close();
 	channelReady.close();
+	channelRecycled.close();
 	waitForThread(true);
 }
 
@@ -24,19 +25,24 @@ void BufferSenderThread::setSaveSize(int w, int h)
 	height = h;
 }
 
-void BufferSenderThread::setProcSize(size_t procSize)
+std::vector<char> BufferSenderThread::acquireBuffer(size_t size)
 {
-	_procSize = procSize;
-}
-
-void BufferSenderThread::setId(uint32_t id)
-{
-	_id = id;
+	std::vector<char> buf;
+	channelRecycled.tryReceive(buf);
+	if (buf.size() < size) {
+		buf.resize(size);
+	}
+	return buf;
 }
 
-void BufferSenderThread::send(ofBuffer* pixels)
+void BufferSenderThread::send(std::vector<char>&& buf, size_t procSize, uint32_t id, Stream stream)
 {
-	channel.send(pixels);
+	Job job;
+	job.buffer = std::move(buf);
+	job.procSize = procSize;
+	job.id = id;
+	job.stream = stream;
+	channel.send(std::move(job));
 }
 
 void BufferSenderThread::waitReady()
@@ -48,48 +54,48 @@ void BufferSenderThread::waitReady()
 
 void BufferSenderThread::threadedFunction()
 {
-	ofBuffer* buf;
-	while(channel.receive(buf))
+	Job job;
+	while(channel.receive(job))
 	{
 		ofxOscMessage msg_start;
+		const std::vector<char>& buf = job.buffer;
+
+		const std::string& addrStart = (job.stream == OBSERVATIONS) ? OSC_OBSERVATIONS_START : (job.stream == PATCHES) ? OSC_PATCH_START : OSC_ARTIFACT_START;
+		const std::string& addrPart = (job.stream == OBSERVATIONS) ? OSC_OBSERVATIONS_PART : (job.stream == PATCHES) ? OSC_PATCH_PART : OSC_ARTIFACT_PART;
+		const std::string& addrEnd = (job.stream == OBSERVATIONS) ? OSC_OBSERVATIONS_END : (job.stream == PATCHES) ? OSC_PATCH_END : OSC_ARTIFACT_END;
 
 		int id = 0;
-		char cbuf[OSC_BUFFER_SIZE];
 		long max = OSC_BUFFER_SIZE;
 		long processed = 0;
-		long procsize = (_procSize > 0) ? _procSize : buf->size();
+		long procsize = (job.procSize > 0) ? job.procSize : buf.size();
 
-		msg_start.setAddress(OSC_ARTIFACT_START);
+		msg_start.setAddress(addrStart);
 		msg_start.addInt32Arg(ceil(procsize / max));
 		sender.sendMessage(msg_start);
 
 		while (processed < procsize)
 		{
 			long available = std::min(max, procsize - processed);
-			memcpy(cbuf, buf->getData() + processed, available);
-			processed += available;
-
-			std::ostringstream ss;
-			ss << OSC_ARTIFACT_PART << id;
-
 			ofBuffer tmpbuf;
-			tmpbuf.set(cbuf, available);
+			tmpbuf.set(buf.data() + processed, available);
+			processed += available;
 
 			ofxOscMessage m;
-			m.setAddress(ss.str());
+			m.setAddress(addrPart + ofToString(id));
 			m.addBlobArg(tmpbuf);
 			sender.sendMessage(m);
 			id++;
 		}
 		ofxOscMessage msg_end;
-		msg_end.setAddress(OSC_ARTIFACT_END);
-		msg_end.addInt32Arg(_id);
+		msg_end.setAddress(addrEnd);
+		msg_end.addInt32Arg(job.id);
 		sender.sendMessage(msg_end);
 
 		//std::ostringstream ss;
 		//ss << "sending " << procsize << " bytes over " << id << " messages.";
 		//ofLog() << ss.str();
 
+		channelRecycled.send(std::move(job.buffer));
 		channelReady.send(true);
 	}
 }
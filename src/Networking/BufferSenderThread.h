@@ -7,28 +7,42 @@
 class BufferSenderThread : public ofThread 
 {
 public:
+	// Artifacts are single conv images, patches are stream mode conv images and observations are batches of them
+	// (see OscProtocol.h)
+	enum Stream { ARTIFACT, PATCHES, OBSERVATIONS };
+
 	BufferSenderThread();
 	~BufferSenderThread();
 
 	void setup(std::string host, int outport);
 	void setSaveSize(int w, int h);
 
-	void setProcSize(size_t procSize);
-	void setId(uint32_t id);
+	// A buffer of at least size bytes, taken from those the thread has finished sending when there are any
+	std::vector<char> acquireBuffer(size_t size);
 
-	void send(ofBuffer* img);
+	// Sends the first procSize bytes of buf (0: all of them) in parts, id goes out with the end message. The job owns
+	// buf until it is sent, so the caller may queue any number of jobs without waiting for the thread
+	void send(std::vector<char>&& buf, size_t procSize, uint32_t id, Stream stream = ARTIFACT);
 	void waitReady();
 	void threadedFunction();
 
 	bool bFirstSave = true;
 
 private:
-	ofThreadChannel<ofBuffer*> channel;
+	struct Job
+	{
+		std::vector<char> buffer;
+		size_t procSize;
+		uint32_t id;
+		Stream stream;
+	};
+
+	ofThreadChannel<Job> channel;
 	ofThreadChannel<bool> channelReady;
 
+	// Buffers of sent jobs, handed out again by acquireBuffer
+	ofThreadChannel<std::vector<char>> channelRecycled;
+
 	ofxOscSender sender;
 	int width, height;
-
-	uint32_t _id = 0;
-	size_t _procSize = 0;
 };
@@ -0,0 +1,116 @@
+#include "FrameDecoder.h"
+#include "lz4.h"
+#include <cstring>
+
+namespace
+{
+	template<typename T>
+	const uint8_t* read(const uint8_t* src, T& value)
+	{
+		memcpy(&value, src, sizeof(T));
+		return src + sizeof(T);
+	}
+}
+
+bool FrameDecoder::decodeDatagram(const uint8_t* data, size_t size, Frame& frame)
+{
+	// "/frm\0\0\0\0" ",b\0\0" int32 blob size (big-endian)
+	const size_t prefixSize = 16;
+	frame.bHeaderValid = false;
+	if (size < prefixSize || memcmp(data, OSC_FRAME.c_str(), OSC_FRAME.size() + 1) != 0 || memcmp(data + 8, ",b\0\0", 4) != 0) {
+		return fail("not a frame message");
+	}
+	uint32_t blobSize = (uint32_t(data[12]) << 24) | (uint32_t(data[13]) << 16) | (uint32_t(data[14]) << 8) | uint32_t(data[15]);
+	if (blobSize > size - prefixSize) {
+		return fail("truncated datagram");
+	}
+	return decode(data + prefixSize, blobSize, frame);
+}
+
+bool FrameDecoder::decode(const uint8_t* data, size_t size, Frame& frame)
+{
+	frame.bHeaderValid = false;
+	if (size < FRAME_HEADER_SIZE) {
+		return fail("truncated header");
+	}
+	uint32_t magic, payloadSize;
+	uint16_t reserved;
+
+	const uint8_t* p = data;
+	p = read(p, magic);
+	p = read(p, frame.version);
+	p = read(p, frame.flags);
+	if (magic != FRAME_MAGIC) {
+		return fail("bad magic");
+	}
+	if (frame.version != FRAME_VERSION) {
+		return fail("unknown version " + std::to_string(frame.version));
+	}
+	p = read(p, frame.agentId);
+	p = read(p, frame.tick);
+	p = read(p, frame.numJoints);
+	p = read(p, frame.width);
+	p = read(p, frame.height);
+	p = read(p, reserved);
+	p = read(p, payloadSize);
+	frame.bHeaderValid = true;
+
+	size_t jointsSize = frame.numJoints * sizeof(float);
+	if (size < FRAME_HEADER_SIZE + jointsSize + payloadSize) {
+		return fail("truncated payload");
+	}
+	frame.joints = reinterpret_cast<const float*>(p);
+	const uint8_t* payload = p + jointsSize;
+
+	size_t patchSize = size_t(frame.width) * frame.height;
+	if (!(frame.flags & FRAME_LZ4)) {
+		if (payloadSize != patchSize) {
+			return fail("payload size does not match patch size");
+		}
+		frame.patch = payload;
+
+		// Raw frames can be followed by delta frames of a sender that switched modes
+		_patches[frame.agentId].assign(payload, payload + patchSize);
+		return true;
+	}
+
+	std::vector<uint8_t>& previous = _patches[frame.agentId];
+	int decoded;
+	if (frame.flags & FRAME_DELTA) {
+		if (previous.size() != patchSize) {
+			return fail("delta frame without previous patch of agent " + std::to_string(frame.agentId));
+		}
+		// The dictionary must stay intact while decoding, so decode next to it
+		_scratch.resize(patchSize);
+		decoded = LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(payload), reinterpret_cast<char*>(_scratch.data()),
+			int(payloadSize), int(patchSize), reinterpret_cast<const char*>(previous.data()), int(patchSize));
+		previous.swap(_scratch);
+	}
+	else {
+		previous.resize(patchSize);
+		decoded = LZ4_decompress_safe(reinterpret_cast<const char*>(payload), reinterpret_cast<char*>(previous.data()),
+			int(payloadSize), int(patchSize));
+	}
+	if (decoded != int(patchSize)) {
+		previous.clear();
+		return fail("corrupt LZ4 payload");
+	}
+	frame.patch = previous.data();
+	return true;
+}
+
+void FrameDecoder::reset(uint32_t agentId)
+{
+	_patches.erase(agentId);
+}
+
+const std::string& FrameDecoder::getError() const
+{
+	return _error;
+}
+
+bool FrameDecoder::fail(const std::string& error)
+{
+	_error = error;
+	return false;
+}
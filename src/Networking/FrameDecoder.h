@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "OscProtocol.h"
+
+// Reference decoder of observation frames (see OscProtocol.h) for the controller side. Has no openFrameworks
+// dependencies, only lz4 for compressed payloads. Keeps the last patch of every agent to resolve delta frames.
+class FrameDecoder
+{
+public:
+	struct Frame
+	{
+		uint16_t version;
+		uint16_t flags;
+		uint32_t agentId;
+		uint32_t tick;
+		uint16_t numJoints;
+		uint16_t width;
+		uint16_t height;
+
+		// The header fields above are valid, also when decoding failed on the payload, e.g. a delta frame whose
+		// previous frame was lost. The agent can then still be answered
+		bool bHeaderValid;
+
+		// Point into the decoded datagram and the decoder, valid until the next decode of the same agent
+		const float* joints;
+		const uint8_t* patch;
+	};
+
+	// A /frm OSC message as received from the socket
+	bool decodeDatagram(const uint8_t* data, size_t size, Frame& frame);
+
+	// The blob of a /frm message, for OSC libraries that unpack it themselves. data must be 4-byte aligned
+	bool decode(const uint8_t* data, size_t size, Frame& frame);
+
+	// Forgets the last patch of an agent, call when its rollout ends
+	void reset(uint32_t agentId);
+
+	// Why the last decode failed
+	const std::string& getError() const;
+
+private:
+	bool fail(const std::string& error);
+
+	std::unordered_map<uint32_t, std::vector<uint8_t>> _patches;
+	std::vector<uint8_t> _scratch;
+	std::string _error;
+};
@@ -0,0 +1,192 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "FrameSender.h"
+#include "ofLog.h"
+#include <cstring>
+
+namespace
+{
+	void writeBigEndian(uint8_t* dst, uint32_t value)
+	{
+		dst[0] = uint8_t(value >> 24);
+		dst[1] = uint8_t(value >> 16);
+		dst[2] = uint8_t(value >> 8);
+		dst[3] = uint8_t(value);
+	}
+
+	template<typename T>
+	uint8_t* write(uint8_t* dst, T value)
+	{
+		memcpy(dst, &value, sizeof(T));
+		return dst + sizeof(T);
+	}
+}
+
+FrameSender::~FrameSender()
+{
+	close();
+}
+
+bool FrameSender::setup(const std::string& host, int port)
+{
+	close();
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		ofLogError() << "[FrameSender] Could not initialize winsock";
+		return false;
+	}
+	_bWinsock = true;
+#endif
+
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	addrinfo* result = nullptr;
+	if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+		ofLogError() << "[FrameSender] Could not resolve " << host;
+		close();
+		return false;
+	}
+	_address = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+	_port = uint16_t(port);
+	freeaddrinfo(result);
+
+	_socket = intptr_t(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+#ifdef _WIN32
+	if (SOCKET(_socket) == INVALID_SOCKET) {
+#else
+	if (_socket < 0) {
+#endif
+		ofLogError() << "[FrameSender] Could not create socket";
+		_socket = -1;
+		close();
+		return false;
+	}
+
+	// The OSC prefix only changes in the blob size
+	memset(_header, 0, sizeof(_header));
+	memcpy(_header, OSC_FRAME.c_str(), OSC_FRAME.size());
+	memcpy(_header + 8, ",b", 2);
+
+	_numFrames = 0;
+	_numBytes = 0;
+	return true;
+}
+
+void FrameSender::close()
+{
+	if (_socket != -1) {
+#ifdef _WIN32
+		closesocket(SOCKET(_socket));
+#else
+		::close(int(_socket));
+#endif
+		_socket = -1;
+	}
+#ifdef _WIN32
+	if (_bWinsock) {
+		WSACleanup();
+		_bWinsock = false;
+	}
+#endif
+}
+
+bool FrameSender::isOpen() const
+{
+	return _socket != -1;
+}
+
+bool FrameSender::send(uint32_t agentId, uint32_t tick, const float* joints, uint16_t numJoints,
+	const uint8_t* payload, uint32_t payloadSize, uint16_t width, uint16_t height, uint16_t flags)
+{
+	if (!isOpen()) {
+		return false;
+	}
+	size_t jointsSize = numJoints * sizeof(float);
+	size_t blobSize = FRAME_HEADER_SIZE + jointsSize + payloadSize;
+	size_t padding = (4 - blobSize % 4) % 4;
+	size_t datagramSize = OSC_PREFIX_SIZE + blobSize + padding;
+	if (datagramSize > FRAME_MAX_DATAGRAM) {
+		return false;
+	}
+
+	writeBigEndian(_header + 12, uint32_t(blobSize));
+
+	uint8_t* h = _header + OSC_PREFIX_SIZE;
+	h = write(h, FRAME_MAGIC);
+	h = write(h, FRAME_VERSION);
+	h = write(h, flags);
+	h = write(h, agentId);
+	h = write(h, tick);
+	h = write(h, numJoints);
+	h = write(h, width);
+	h = write(h, height);
+	h = write(h, uint16_t(0));
+	h = write(h, payloadSize);
+
+	static const uint8_t zeros[4] = { 0, 0, 0, 0 };
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = _address;
+	addr.sin_port = htons(_port);
+
+#ifdef _WIN32
+	WSABUF buffers[4] = {
+		{ ULONG(sizeof(_header)), reinterpret_cast<CHAR*>(_header) },
+		{ ULONG(jointsSize), reinterpret_cast<CHAR*>(const_cast<float*>(joints)) },
+		{ ULONG(payloadSize), reinterpret_cast<CHAR*>(const_cast<uint8_t*>(payload)) },
+		{ ULONG(padding), reinterpret_cast<CHAR*>(const_cast<uint8_t*>(zeros)) }
+	};
+	DWORD sent = 0;
+	bool bSent = WSASendTo(SOCKET(_socket), buffers, 4, &sent, 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr), nullptr, nullptr) == 0;
+#else
+	iovec buffers[4] = {
+		{ _header, sizeof(_header) },
+		{ const_cast<float*>(joints), jointsSize },
+		{ const_cast<uint8_t*>(payload), payloadSize },
+		{ const_cast<uint8_t*>(zeros), padding }
+	};
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_iov = buffers;
+	msg.msg_iovlen = 4;
+	ssize_t sent = sendmsg(int(_socket), &msg, 0);
+	bool bSent = sent == ssize_t(datagramSize);
+#endif
+
+	if (!bSent) {
+		return false;
+	}
+	_numFrames++;
+	_numBytes += datagramSize;
+	return true;
+}
+
+uint64_t FrameSender::getNumFrames() const
+{
+	return _numFrames;
+}
+
+uint64_t FrameSender::getNumBytes() const
+{
+	return _numBytes;
+}
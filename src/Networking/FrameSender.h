@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "OscProtocol.h"
+
+// Sends observation frames (see OscProtocol.h) over UDP. A frame goes out as one datagram gathered from the header,
+// joint state and patch where they are, so neither of them is copied into a message buffer first.
+class FrameSender
+{
+public:
+	~FrameSender();
+
+	bool setup(const std::string& host, int port);
+	void close();
+	bool isOpen() const;
+
+	// Returns false if the frame does not fit in a datagram or could not be sent
+	bool send(uint32_t agentId, uint32_t tick, const float* joints, uint16_t numJoints,
+		const uint8_t* payload, uint32_t payloadSize, uint16_t width, uint16_t height, uint16_t flags);
+
+	uint64_t getNumFrames() const;
+	uint64_t getNumBytes() const;
+
+private:
+	// OSC message prefix (address, type tags and blob size) followed by the frame header
+	static const size_t OSC_PREFIX_SIZE = 16;
+	uint8_t _header[OSC_PREFIX_SIZE + FRAME_HEADER_SIZE];
+
+	intptr_t _socket = -1;
+	uint32_t _address = 0;
+	uint16_t _port = 0;
+	bool _bWinsock = false;
+
+	uint64_t _numFrames = 0;
+	uint64_t _numBytes = 0;
+};
@@ -0,0 +1,198 @@
+#include "LatencyMonitor.h"
+#include "ofUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+void LatencyHistogram::add(uint64_t micros)
+{
+	size_t bucket = (micros > 1) ? size_t(std::log2(double(micros)) * 4.0) : 0;
+	_counts[std::min(bucket, NUM_BUCKETS - 1)]++;
+	_count++;
+	_sumMicros += micros;
+	_maxMicros = std::max(_maxMicros, micros);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	for (size_t i = 0; i < NUM_BUCKETS; i++) {
+		_counts[i] += other._counts[i];
+	}
+	_count += other._count;
+	_sumMicros += other._sumMicros;
+	_maxMicros = std::max(_maxMicros, other._maxMicros);
+}
+
+void LatencyHistogram::clear()
+{
+	_counts.fill(0);
+	_count = 0;
+	_sumMicros = 0;
+	_maxMicros = 0;
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+	return _count;
+}
+
+double LatencyHistogram::getMeanMicros() const
+{
+	return (_count > 0) ? double(_sumMicros) / _count : 0.0;
+}
+
+uint64_t LatencyHistogram::getMaxMicros() const
+{
+	return _maxMicros;
+}
+
+double LatencyHistogram::getPercentileMicros(double q) const
+{
+	if (_count == 0) {
+		return 0.0;
+	}
+	uint64_t rank = uint64_t(std::ceil(q * _count));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < NUM_BUCKETS; i++) {
+		seen += _counts[i];
+		if (seen >= rank && seen > 0) {
+			// never above the largest sample
+			return std::min(getBucketUpperMicros(i), double(_maxMicros));
+		}
+	}
+	return double(_maxMicros);
+}
+
+uint64_t LatencyHistogram::getBucketCount(size_t bucket) const
+{
+	return _counts[bucket];
+}
+
+double LatencyHistogram::getBucketUpperMicros(size_t bucket)
+{
+	return std::pow(2.0, (bucket + 1) / 4.0);
+}
+
+std::vector<float> LatencyHistogram::getPlotValues() const
+{
+	size_t first = NUM_BUCKETS, last = 0;
+	for (size_t i = 0; i < NUM_BUCKETS; i++) {
+		if (_counts[i] > 0) {
+			first = std::min(first, i);
+			last = i;
+		}
+	}
+	if (first == NUM_BUCKETS) {
+		return std::vector<float>(1, 0.0f);
+	}
+	return std::vector<float>(_counts.begin() + first, _counts.begin() + last + 1);
+}
+
+void LatencyMonitor::observationSent(uint32_t agentId)
+{
+	uint64_t now = ofGetElapsedTimeMicros();
+	Agent& agent = _agents[agentId];
+
+	if (agent.bAwaitingObservation) {
+		uint64_t micros = now - agent.actionMicros;
+		agent.histograms[ACTION_TO_OBSERVATION].add(micros);
+		_total[ACTION_TO_OBSERVATION].add(micros);
+		agent.bAwaitingObservation = false;
+	}
+	agent.observationMicros = now;
+	agent.bAwaitingAction = true;
+}
+
+void LatencyMonitor::actionReceived(uint32_t agentId)
+{
+	uint64_t now = ofGetElapsedTimeMicros();
+	Agent& agent = _agents[agentId];
+
+	// A newer action for an observation that was already answered only replaces the previous one
+	if (!agent.bAwaitingAction) {
+		return;
+	}
+	uint64_t micros = now - agent.observationMicros;
+	agent.histograms[OBSERVATION_TO_ACTION].add(micros);
+	_total[OBSERVATION_TO_ACTION].add(micros);
+
+	agent.actionMicros = now;
+	agent.bAwaitingAction = false;
+	agent.bAwaitingObservation = true;
+}
+
+void LatencyMonitor::endRollout(uint32_t agentId)
+{
+	auto it = _agents.find(agentId);
+	if (it != _agents.end()) {
+		it->second.bAwaitingAction = false;
+		it->second.bAwaitingObservation = false;
+	}
+}
+
+void LatencyMonitor::clear()
+{
+	_agents.clear();
+	for (LatencyHistogram& total : _total) {
+		total.clear();
+	}
+}
+
+const LatencyHistogram& LatencyMonitor::getTotal(Metric metric) const
+{
+	return _total[metric];
+}
+
+const std::map<uint32_t, LatencyMonitor::Agent>& LatencyMonitor::getAgents() const
+{
+	return _agents;
+}
+
+bool LatencyMonitor::writeCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+	file << "agent,metric,count,mean_us,p50_us,p90_us,p99_us,max_us";
+	for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+		// The lowest edges are less than 1us apart, keep them distinct
+		double edge = LatencyHistogram::getBucketUpperMicros(i);
+		file << ",le_";
+		if (edge < 100.0) {
+			file << std::round(edge * 100.0) / 100.0;
+		}
+		else {
+			file << uint64_t(std::ceil(edge));
+		}
+		file << "us";
+	}
+	file << '\n';
+
+	auto writeRow = [&file](const std::string& agent, Metric metric, const LatencyHistogram& h) {
+		file << agent << ',' << metricToString(metric) << ',' << h.getCount() << ',' << h.getMeanMicros() << ',' <<
+			h.getPercentileMicros(0.5) << ',' << h.getPercentileMicros(0.9) << ',' << h.getPercentileMicros(0.99) << ',' << h.getMaxMicros();
+		for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+			file << ',' << h.getBucketCount(i);
+		}
+		file << '\n';
+	};
+	for (int m = 0; m < NUM_METRICS; m++) {
+		writeRow("all", Metric(m), _total[m]);
+	}
+	for (const auto& agent : _agents) {
+		for (int m = 0; m < NUM_METRICS; m++) {
+			writeRow(ofToString(agent.first), Metric(m), agent.second.histograms[m]);
+		}
+	}
+	return bool(file);
+}
+
+std::string LatencyMonitor::metricToString(Metric metric)
+{
+	switch (metric) {
+	case OBSERVATION_TO_ACTION: return "obs_to_act";
+	case ACTION_TO_OBSERVATION: return "act_to_obs";
+	default: return "unknown";
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Log-scale histogram of durations, four buckets per octave from 1us up to about 17s
+class LatencyHistogram
+{
+public:
+	static const size_t NUM_BUCKETS = 96;
+
+	void add(uint64_t micros);
+	void merge(const LatencyHistogram& other);
+	void clear();
+
+	uint64_t getCount() const;
+	double getMeanMicros() const;
+	uint64_t getMaxMicros() const;
+
+	// Upper edge of the bucket that holds quantile q [0..1]
+	double getPercentileMicros(double q) const;
+
+	uint64_t getBucketCount(size_t bucket) const;
+	static double getBucketUpperMicros(size_t bucket);
+
+	// Counts as floats for ImGui::PlotHistogram, from the first to the last bucket that is not empty
+	std::vector<float> getPlotValues() const;
+
+private:
+	std::array<uint64_t, NUM_BUCKETS> _counts = {};
+	uint64_t _count = 0;
+	uint64_t _sumMicros = 0;
+	uint64_t _maxMicros = 0;
+};
+
+// Control loop latency per agent as the simulator sees it:
+//   observation to action: from handing off an observation until the action that answers it is received
+//   action to observation: from receiving an action until the next observation of the agent is handed off
+// Only the main thread may use it.
+class LatencyMonitor
+{
+public:
+	enum Metric { OBSERVATION_TO_ACTION, ACTION_TO_OBSERVATION, NUM_METRICS };
+
+	struct Agent
+	{
+		LatencyHistogram histograms[NUM_METRICS];
+		uint64_t observationMicros = 0;
+		uint64_t actionMicros = 0;
+		bool bAwaitingAction = false;
+		bool bAwaitingObservation = false;
+	};
+
+	void observationSent(uint32_t agentId);
+	void actionReceived(uint32_t agentId);
+
+	// The next observation of agentId starts a new rollout, so it is not timed against the last action
+	void endRollout(uint32_t agentId);
+	void clear();
+
+	const LatencyHistogram& getTotal(Metric metric) const;
+	const std::map<uint32_t, Agent>& getAgents() const;
+
+	// One row per agent and metric plus totals: summary columns followed by the count of every bucket
+	bool writeCsv(const std::string& path) const;
+
+	static std::string metricToString(Metric metric);
+
+private:
+	std::map<uint32_t, Agent> _agents;
+	LatencyHistogram _total[NUM_METRICS];
+};
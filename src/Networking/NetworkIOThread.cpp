@@ -0,0 +1,192 @@
+#include "NetworkIOThread.h"
+#include "OscProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+NetworkIOThread::~NetworkIOThread()
+{
+	stop();
+}
+
+bool NetworkIOThread::start(std::string host, int inPort, int outPort, const OscRouter* router, size_t numJoints, size_t numOutputs, uint32_t capacity)
+{
+	stop();
+
+	_router = router;
+	_numJoints = numJoints;
+	_numOutputs = numOutputs;
+	_inbound.allocate(capacity, sizeof(Message) + numOutputs * sizeof(float));
+	_outbound.allocate(capacity, sizeof(uint32_t) + numJoints * sizeof(float));
+	_jointsBuffer.allocate(numJoints * sizeof(float));
+	_numDropped = 0;
+
+	_sender.setup(host, outPort);
+
+	// Rings must exist before the first datagram is processed
+	_receiver.owner = this;
+	if (!_receiver.setup(inPort)) {
+		return false;
+	}
+	_bRunning = true;
+	startThread();
+	return true;
+}
+
+void NetworkIOThread::stop()
+{
+	if (!_bRunning) {
+		return;
+	}
+	_receiver.stop();
+
+	stopThread();
+	{
+		std::lock_guard<std::mutex> lock(_outboundMutex);
+	}
+	_outboundCondition.notify_one();
+	waitForThread(false);
+
+	_sender.clear();
+	_bRunning = false;
+}
+
+bool NetworkIOThread::isRunning() const
+{
+	return _bRunning;
+}
+
+void NetworkIOThread::Receiver::ProcessMessage(const osc::ReceivedMessage& m, const osc::IpEndpointName& remoteEndpoint)
+{
+	owner->receive(m);
+}
+
+void NetworkIOThread::receive(const osc::ReceivedMessage& m)
+{
+	const char* address = m.AddressPattern();
+	size_t addressSize = strlen(address);
+
+	int route = _router->match(address, addressSize, _address);
+	if (route == OscRouter::NO_ROUTE) {
+		return;
+	}
+	if (addressSize > Message::MAX_ADDRESS) {
+		ofLogWarning() << "Dropped message with oversized address " << address;
+		_numDropped++;
+		return;
+	}
+
+	uint8_t* record = _inbound.beginPush();
+	if (!record) {
+		ofLogWarning() << "Inbound network ring is full, dropped " << address;
+		_numDropped++;
+		return;
+	}
+	Message* msg = reinterpret_cast<Message*>(record);
+	msg->route = route;
+	msg->numValues = 0;
+	msg->arg = 0.0f;
+	msg->addressSize = uint32_t(addressSize);
+	memcpy(msg->address, address, addressSize);
+
+	// Only the first argument is used: the blob of an action goes straight into the ring, numbers (pulse) into arg
+	try {
+		if (m.ArgumentCount() > 0) {
+			osc::ReceivedMessage::const_iterator arg = m.ArgumentsBegin();
+			if (arg->IsBlob()) {
+				const void* data;
+				osc::osc_bundle_element_size_t size;
+				arg->AsBlob(data, size);
+
+				size_t numValues = std::min(size_t(size) / sizeof(float), _numOutputs);
+				memcpy(record + sizeof(Message), data, numValues * sizeof(float));
+				msg->numValues = uint32_t(numValues);
+			}
+			else if (arg->IsFloat()) {
+				msg->arg = arg->AsFloat();
+			}
+			else if (arg->IsInt32()) {
+				msg->arg = float(arg->AsInt32());
+			}
+		}
+	}
+	catch (std::exception& e) {
+		ofLogWarning() << "Dropped malformed message " << address << ": " << e.what();
+		_numDropped++;
+		return;
+	}
+	_inbound.commitPush();
+
+	{
+		std::lock_guard<std::mutex> lock(_inboundMutex);
+	}
+	_inboundCondition.notify_one();
+}
+
+const NetworkIOThread::Message* NetworkIOThread::peekMessage()
+{
+	return reinterpret_cast<const Message*>(_inbound.front());
+}
+
+void NetworkIOThread::popMessage()
+{
+	_inbound.pop();
+}
+
+bool NetworkIOThread::waitForMessages(uint32_t timeoutMicros)
+{
+	if (!_inbound.empty()) {
+		return true;
+	}
+	std::unique_lock<std::mutex> lock(_inboundMutex);
+	return _inboundCondition.wait_for(lock, std::chrono::microseconds(timeoutMicros), [this] {
+		return !_inbound.empty();
+	});
+}
+
+bool NetworkIOThread::sendJoints(const float* joints, size_t numJoints)
+{
+	uint8_t* record = _outbound.beginPush();
+	if (!record) {
+		return false;
+	}
+	uint32_t n = uint32_t(std::min(numJoints, _numJoints));
+	memcpy(record, &n, sizeof(uint32_t));
+	memcpy(record + sizeof(uint32_t), joints, n * sizeof(float));
+	_outbound.commitPush();
+
+	{
+		std::lock_guard<std::mutex> lock(_outboundMutex);
+	}
+	_outboundCondition.notify_one();
+	return true;
+}
+
+uint64_t NetworkIOThread::getNumDropped() const
+{
+	return _numDropped;
+}
+
+void NetworkIOThread::threadedFunction()
+{
+	while (isThreadRunning()) {
+		{
+			std::unique_lock<std::mutex> lock(_outboundMutex);
+			_outboundCondition.wait(lock, [this] {
+				return !_outbound.empty() || !isThreadRunning();
+			});
+		}
+
+		while (const uint8_t* record = _outbound.front()) {
+			uint32_t n;
+			memcpy(&n, record, sizeof(uint32_t));
+			_jointsBuffer.set(reinterpret_cast<const char*>(record + sizeof(uint32_t)), n * sizeof(float));
+			_outbound.pop();
+
+			_jointsMessage.clear();
+			_jointsMessage.setAddress(OSC_JOINTS);
+			_jointsMessage.addBlobArg(_jointsBuffer);
+			_sender.sendMessage(_jointsMessage);
+		}
+	}
+}
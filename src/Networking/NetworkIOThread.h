@@ -0,0 +1,86 @@
+#pragma once
+#include "ofThread.h"
+#include "ofxOsc.h"
+#include "OscRouter.h"
+#include "Utils/SpscRing.h"
+#include <condition_variable>
+#include <mutex>
+
+// Moves OSC traffic of the simulation loop off the main thread.
+// Incoming messages are decoded on the listen thread of the receiver as soon as their datagram lands and handed to the
+// main thread through an inbound ring; waitForMessages wakes the main thread when one arrives. Outgoing joint states
+// are pushed into an outbound ring and sent from the thread of this object. Both rings are single-producer/
+// single-consumer, so neither side ever takes a lock on the hot path.
+class NetworkIOThread : public ofThread
+{
+public:
+	// A decoded message, followed by numValues floats (the blob of an action)
+	struct Message
+	{
+		static const size_t MAX_ADDRESS = 120;
+
+		int32_t route;
+		uint32_t numValues;
+		float arg;
+		uint32_t addressSize;
+		char address[MAX_ADDRESS];
+
+		const float* getValues() const { return reinterpret_cast<const float*>(this + 1); }
+	};
+
+	~NetworkIOThread();
+
+	// Allocates rings of capacity messages each way and starts listening. router is used by the listen thread and
+	// must stay alive and unchanged until stop. Returns false if the port could not be opened
+	bool start(std::string host, int inPort, int outPort, const OscRouter* router, size_t numJoints, size_t numOutputs, uint32_t capacity);
+	void stop();
+	bool isRunning() const;
+
+	// Main thread: the oldest decoded message or nullptr, release it with popMessage
+	const Message* peekMessage();
+	void popMessage();
+
+	// Main thread: blocks until a message is available or timeoutMicros passed, returns true if one is available
+	bool waitForMessages(uint32_t timeoutMicros);
+
+	// Main thread: returns false if the outbound ring is full
+	bool sendJoints(const float* joints, size_t numJoints);
+
+	uint64_t getNumDropped() const;
+
+	void threadedFunction();
+
+private:
+	class Receiver : public ofxOscReceiver
+	{
+	public:
+		NetworkIOThread* owner = nullptr;
+
+	protected:
+		virtual void ProcessMessage(const osc::ReceivedMessage& m, const osc::IpEndpointName& remoteEndpoint) override;
+	};
+
+	// Listen thread
+	void receive(const osc::ReceivedMessage& m);
+
+	Receiver _receiver;
+	const OscRouter* _router = nullptr;
+	OscAddress _address;
+
+	ofxOscSender _sender;
+	ofxOscMessage _jointsMessage;
+	ofBuffer _jointsBuffer;
+
+	SpscRing _inbound;
+	SpscRing _outbound;
+	size_t _numJoints = 0;
+	size_t _numOutputs = 0;
+	bool _bRunning = false;
+
+	std::mutex _inboundMutex;
+	std::condition_variable _inboundCondition;
+	std::mutex _outboundMutex;
+	std::condition_variable _outboundCondition;
+
+	std::atomic<uint64_t> _numDropped{ 0 };
+};
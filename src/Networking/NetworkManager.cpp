@@ -1,31 +1,98 @@
 #include "NetworkManager.h"
 #include "OscProtocol.h"
 
-void NetworkManager::setup(std::string host, int inPort, int outPort)
+void NetworkManager::setup(std::string host, int inPort, int outPort, Transport transport, std::string shmName, bool bBatchObservations, bool bAsyncIO)
 {
+	_transport = transport;
+	_shmName = shmName;
+	_bBatchObservations = bBatchObservations;
+	_bAsyncIO = bAsyncIO;
+	_host = host;
+	_inPort = inPort;
+	_outPort = outPort;
 	_bufferSender.setup(host, outPort);
 
 	_sender.setup(host, outPort);
-	_receiver.setup(inPort);
+
+	// The I/O thread listens once its rings are allocated
+	if (!_bAsyncIO) {
+		_receiver.setup(inPort);
+	}
+
+	_router.clear();
+	_router.add(OSC_HELLO_IN, ROUTE_HELLO);
+	_router.add(OSC_INFO_IN, ROUTE_INFO);
+	_router.add(OSC_BYE_IN, ROUTE_BYE);
+	_router.add(OSC_ACTIVATION, ROUTE_ACTIVATION);
+	_router.add(OSC_PULSE, ROUTE_PULSE);
+	_router.add(OSC_FITNESS_IN, ROUTE_FITNESS);
 
 	_state = HANDSHAKE;
 }
 
-void NetworkManager::allocate(size_t numJoints, size_t numOutputs, uint32_t w, uint32_t h, ofPixelFormat type)
+void NetworkManager::allocate(size_t numJoints, size_t numOutputs, uint32_t w, uint32_t h, ofPixelFormat type, uint32_t numAgents)
 {
 	_outputBufferSize = numOutputs;
-	_outputBuffer.resize(numOutputs);
+	_actionTable.clear();
+	_numQueuedOutputs = 0;
+	_latencyMonitor.clear();
 
 	_jointsInputBufferSize = numJoints;
 	_jointsInputBuffer.resize(numJoints);
 
-	_bufferSender.allocate(w, h, type);
+	_patchWidth = w;
+	_patchHeight = h;
+	_batchJoints.clear();
+	_batchPatches.clear();
+	_batchSlots.clear();
+
+	if (_transport == SHM) {
+		if (!_shmChannel.create(_shmName, numAgents, numJoints, numOutputs, w, h)) {
+			ofLogError() << "Could not create shared memory channel '" << _shmName << "', falling back to OSC";
+			_transport = OSC;
+		}
+		_shmActionBuffer.resize(numOutputs);
+	}
+	if (_transport == OSC) {
+		_bufferSender.allocate(w, h, type);
+	}
+
+	if (_bAsyncIO) {
+		// A few messages per agent can be in flight in either direction
+		uint32_t capacity = std::max(numAgents * 4, 64u);
+		if (!_ioThread.start(_host, _inPort, _outPort, &_router, numJoints, numOutputs, capacity)) {
+			ofLogError() << "Could not start network I/O thread on port " << _inPort << ", falling back to polling";
+			_bAsyncIO = false;
+			_receiver.setup(_inPort);
+		}
+	}
 }
 
 void NetworkManager::sendState(SimInstance* instance)
 {
-	ofBuffer buf;
+	_latencyMonitor.observationSent(instance->getID());
+
+	if (_transport == SHM) {
+		if (!_shmChannel.writeObservation(instance->getID(), &instance->getCreature()->getJointState()[0], instance->getCanvas()->getConvPixelBuffer().getData())) {
+			ofLogWarning() << "Shared memory observation ring is full or agent has no slot, dropped observation of agent " << instance->getID();
+		}
+		return;
+	}
+	if (_bBatchObservations) {
+		batchState(instance);
+		return;
+	}
+	if (_bObservationFrames && sendFrame(instance)) {
+		return;
+	}
+
 	const std::vector<float>& jointState = instance->getCreature()->getJointState();
+	if (_bAsyncIO && _ioThread.sendJoints(&jointState[0], instance->getCreature()->getNumJoints())) {
+		_bufferSender.send(instance->getCanvas()->getConvPixelBuffer(), instance->getID());
+		return;
+	}
+
+	ofBuffer buf;
 	buf.set((char*)&jointState[0], instance->getCreature()->getNumJoints()*sizeof(float));
 	
 	ofxOscMessage joints;
@@ -36,6 +103,112 @@ void NetworkManager::sendState(SimInstance* instance)
 	_bufferSender.send(instance->getCanvas()->getConvPixelBuffer(), instance->getID());
 }
 
+void NetworkManager::batchState(SimInstance* instance)
+{
+	const size_t jointsSize = sizeof(uint32_t) + _jointsInputBufferSize * sizeof(float);
+	const size_t patchSize = _patchWidth * _patchHeight;
+
+	// A second observation of an agent within the same tick replaces the first
+	auto slot = _batchSlots.find(instance->getID());
+	uint32_t i = (slot != _batchSlots.end()) ? slot->second : uint32_t(_batchSlots.size());
+	if (slot == _batchSlots.end()) {
+		_batchSlots.emplace(instance->getID(), i);
+		_batchJoints.resize((i + 1) * jointsSize);
+		_batchPatches.resize((i + 1) * patchSize);
+	}
+
+	uint8_t* joints = &_batchJoints[i * jointsSize];
+	const std::vector<float>& jointState = instance->getCreature()->getJointState();
+	size_t numJoints = std::min(size_t(instance->getCreature()->getNumJoints()), _jointsInputBufferSize);
+
+	uint32_t agentId = instance->getID();
+	memcpy(joints, &agentId, sizeof(uint32_t));
+	memset(joints + sizeof(uint32_t), 0, _jointsInputBufferSize * sizeof(float));
+	memcpy(joints + sizeof(uint32_t), &jointState[0], numJoints * sizeof(float));
+
+	memcpy(&_batchPatches[i * patchSize], instance->getCanvas()->getConvPixelBuffer().getData(), patchSize);
+}
+
+bool NetworkManager::sendFrame(SimInstance* instance)
+{
+	const std::vector<float>& jointState = instance->getCreature()->getJointState();
+	const uint8_t* patch = instance->getCanvas()->getConvPixelBuffer().getData();
+	uint16_t numJoints = uint16_t(std::min(size_t(instance->getCreature()->getNumJoints()), _jointsInputBufferSize));
+	uint32_t patchSize = _patchWidth * _patchHeight;
+
+	const uint8_t* payload = patch;
+	uint32_t payloadSize = patchSize;
+	uint16_t flags = 0;
+
+	if (_bufferSender.isStreamMode()) {
+		bool bKeyframe;
+		size_t compSize = _bufferSender.encodePatch(patch, instance->getID(), &_framePayload[0], bKeyframe);
+		if (compSize > 0) {
+			payload = reinterpret_cast<const uint8_t*>(&_framePayload[0]);
+			payloadSize = uint32_t(compSize);
+			flags = bKeyframe ? FRAME_LZ4 : FRAME_LZ4 | FRAME_DELTA;
+		}
+	}
+	if (!_frameSender.send(instance->getID(), instance->getNumAwaits(), &jointState[0], numJoints, payload, payloadSize,
+		uint16_t(_patchWidth), uint16_t(_patchHeight), flags)) {
+		ofLogWarning() << "Could not send observation frame of agent " << instance->getID() << ", falling back to /jnts and /art/";
+
+		// The receiver has not seen the patch that was just encoded
+		_bufferSender.resetStream(instance->getID());
+		return false;
+	}
+	return true;
+}
+
+void NetworkManager::flushObservations()
+{
+	if (_batchSlots.empty()) {
+		return;
+	}
+	const uint32_t header[4] = { uint32_t(_batchSlots.size()), uint32_t(_jointsInputBufferSize), _patchWidth, _patchHeight };
+
+	_batchBuffer.resize(sizeof(header) + _batchJoints.size() + _batchPatches.size());
+	memcpy(&_batchBuffer[0], header, sizeof(header));
+	memcpy(&_batchBuffer[sizeof(header)], &_batchJoints[0], _batchJoints.size());
+	memcpy(&_batchBuffer[sizeof(header) + _batchJoints.size()], &_batchPatches[0], _batchPatches.size());
+
+	_bufferSender.sendBatch(&_batchBuffer[0], _batchBuffer.size(), _batchSeq++);
+
+	_batchJoints.clear();
+	_batchPatches.clear();
+	_batchSlots.clear();
+}
+
+void NetworkManager::setPatchStream(bool enable, uint32_t keyframeInterval)
+{
+	_bufferSender.setStreamMode(enable, keyframeInterval);
+}
+
+void NetworkManager::resetPatchStream(uint32_t agentId)
+{
+	_bufferSender.resetStream(agentId);
+}
+
+void NetworkManager::setObservationFrames(bool enable)
+{
+	_bObservationFrames = enable && _transport == OSC;
+	if (_bObservationFrames) {
+		_framePayload.resize(_bufferSender.getPatchBound());
+		if (!_frameSender.setup(_host, _outPort)) {
+			ofLogError() << "Could not open observation frame socket, falling back to /jnts and /art/";
+			_bObservationFrames = false;
+		}
+	}
+	else {
+		_frameSender.close();
+	}
+}
+
+bool NetworkManager::isSendingFrames()
+{
+	return _bObservationFrames;
+}
+
 void NetworkManager::send(std::string addr)
 {
 	ofxOscMessage msg;
@@ -83,58 +256,54 @@ void NetworkManager::send(std::string addr, const std::vector<double>& values)
 
 void NetworkManager::receive()
 {
+	if (_transport == SHM && _shmChannel.isOpen()) {
+		uint32_t agentId;
+		while (_shmChannel.readAction(agentId, &_shmActionBuffer[0])) {
+			queueAction(agentId, &_shmActionBuffer[0], _shmActionBuffer.size());
+		}
+	}
+
+	if (_bAsyncIO) {
+		// Already decoded by the I/O thread, only the address is parsed again for its arguments
+		while (const NetworkIOThread::Message* msg = _ioThread.peekMessage()) {
+			_address.parse(msg->address, msg->addressSize);
+			bool bContinue = dispatch(msg->route, msg->getValues(), msg->numValues, msg->arg);
+			_ioThread.popMessage();
+
+			if (!bContinue) {
+				break;
+			}
+		}
+		return;
+	}
+
 	if (_receiver.isListening()) {
 		bool bMsgInQueue = _receiver.hasWaitingMessages();
 
 		if (bMsgInQueue) {
-			ofBuffer buf;
 			bool bMsgStart = false;
 			int numFrameParts = 0;
 
 			while (_receiver.hasWaitingMessages()) {
-				ofxOscMessage m;
-				_receiver.getNextMessage(&m);
-
-				std::vector<std::string> tokens = ofSplitString(m.getAddress(), "/");
-				const std::string& addr_id = tokens[1];
-
-				if (addr_id == OSC_HELLO_IN) {
-					if (_repeatMessageScheduler.isThreadRunning()) {
-						_repeatMessageScheduler.stopThread();
-						_handshakeListener.unsubscribe();
-					}
-					_state = ACTIVE;
-					onConnectionEstablished.notify();
-					break;
-				}
-				if (addr_id == OSC_INFO_IN) {
-					SimInfo info;
-					info.ga_id = tokens[2];
-					info.candidate_id = ofToInt(tokens[3]);
-					info.generation = ofToInt(tokens[4]);
-					info.duration = ofToInt(tokens[5]);
-					onInfoReceived.notify(info);
-					break;
-				}
-				if (addr_id == OSC_BYE_IN) {
-					onConnectionClosed.notify();
-					break;
-				}
+				// Reused, so the address keeps its capacity across messages
+				ofxOscMessage& m = _message;
+				_receiver.getNextMessage(m);
+
+				int route = _router.match(m.getAddress(), _address);
 
-				// Receive neural network effector vector
-				if (addr_id == OSC_ACTIVATION) {
-					_queuedAgentId = ofToInt(tokens[2]);
-					buf.append(m.getArgAsBlob(0));
-					memcpy(&_outputBuffer[0], buf.getData(), _outputBufferSize * sizeof(float));
-					_bOutputQueued = true;
+				const float* values = nullptr;
+				size_t numValues = 0;
+				float arg = 0.0f;
+				if (route == ROUTE_ACTIVATION) {
+					const ofBuffer& blob = m.getArgAsBlob(0);
+					values = reinterpret_cast<const float*>(blob.getData());
+					numValues = blob.size() / sizeof(float);
 				}
-				if (addr_id == OSC_PULSE) {
-					float pulse = m.getArgAsFloat(0);
-					onPulseReceived.notify(pulse);
+				else if (route == ROUTE_PULSE) {
+					arg = m.getArgAsFloat(0);
 				}
-				// Receive fitness request
-				if (addr_id == OSC_FITNESS_IN) {
-					onFitnessRequestReceived.notify();
+				if (!dispatch(route, values, numValues, arg)) {
+					break;
 				}
 			}
 			//std::ostringstream ss;
@@ -144,6 +313,55 @@ void NetworkManager::receive()
 	}
 }
 
+bool NetworkManager::dispatch(int route, const float* values, size_t numValues, float arg)
+{
+	if (route == ROUTE_HELLO) {
+		if (_repeatMessageScheduler.isThreadRunning()) {
+			_repeatMessageScheduler.stopThread();
+			_handshakeListener.unsubscribe();
+		}
+		_state = ACTIVE;
+		onConnectionEstablished.notify();
+		return false;
+	}
+	if (route == ROUTE_INFO) {
+		SimInfo info = SimInfo();
+		info.ga_id = _address.getString(1);
+		_address.toUInt(2, info.candidate_id);
+		_address.toUInt(3, info.generation);
+		_address.toUInt(4, info.duration);
+		onInfoReceived.notify(info);
+		return false;
+	}
+	if (route == ROUTE_BYE) {
+		onConnectionClosed.notify();
+		return false;
+	}
+
+	// Receive neural network effector vector, copied from the blob straight into the action of the agent
+	if (route == ROUTE_ACTIVATION) {
+		uint32_t agentId;
+		if (!_address.toUInt(1, agentId)) {
+			ofLogWarning() << "Dropped action with invalid address " << _address.getString(0) << '/' << _address.getString(1);
+			return true;
+		}
+		queueAction(agentId, values, numValues);
+	}
+	if (route == ROUTE_PULSE) {
+		onPulseReceived.notify(arg);
+	}
+	// Receive fitness request
+	if (route == ROUTE_FITNESS) {
+		onFitnessRequestReceived.notify();
+	}
+	return true;
+}
+
+bool NetworkManager::waitForMessages(uint32_t timeoutMicros)
+{
+	return _bAsyncIO && _ioThread.waitForMessages(timeoutMicros);
+}
+
 void NetworkManager::search()
 {
 	if (!_repeatMessageScheduler.isThreadRunning()) {
@@ -165,25 +383,104 @@ void NetworkManager::close()
 	}
 	_sender.clear();
 	_receiver.stop();
+	_ioThread.stop();
+	_shmChannel.close();
 }
 
-bool NetworkManager::isAgentOutputQueued()
+void NetworkManager::beginRollout(uint32_t agentId)
 {
-	return _bOutputQueued;
+	AgentAction& action = _actionTable[agentId];
+	action.outputs.assign(_outputBufferSize, 0.0f);
+	if (action.bQueued) {
+		action.bQueued = false;
+		_numQueuedOutputs--;
+	}
+	if (_transport == SHM && _shmChannel.isOpen() && !_shmChannel.acquireSlot(agentId)) {
+		ofLogError() << "No free shared memory slot for agent " << agentId << ", its observations are dropped";
+	}
+}
+
+void NetworkManager::endRollout(uint32_t agentId)
+{
+	auto it = _actionTable.find(agentId);
+	if (it != _actionTable.end()) {
+		if (it->second.bQueued) {
+			_numQueuedOutputs--;
+		}
+		_actionTable.erase(it);
+	}
+	if (_transport == SHM && _shmChannel.isOpen()) {
+		_shmChannel.releaseSlot(agentId);
+	}
+	resetPatchStream(agentId);
+	_latencyMonitor.endRollout(agentId);
+}
+
+void NetworkManager::queueAction(uint32_t agentId, const float* outputs, size_t size)
+{
+	// Late actions of an ended rollout must not become the first action of the next candidate with the same id
+	auto it = _actionTable.find(agentId);
+	if (it == _actionTable.end()) {
+		ofLogVerbose() << "Dropped action of agent " << agentId << " without a running rollout";
+		return;
+	}
+	_latencyMonitor.actionReceived(agentId);
+
+	// Outputs missing from a short action are zero, not left over from the previous one
+	AgentAction& action = it->second;
+	size_t numOutputs = std::min(size, _outputBufferSize);
+	memcpy(&action.outputs[0], outputs, numOutputs * sizeof(float));
+	std::fill(action.outputs.begin() + numOutputs, action.outputs.end(), 0.0f);
+
+	// A newer action for the same agent replaces the unconsumed one
+	if (!action.bQueued) {
+		action.bQueued = true;
+		_numQueuedOutputs++;
+	}
+}
+
+bool NetworkManager::isAgentOutputQueued(uint32_t agentId)
+{
+	auto it = _actionTable.find(agentId);
+	return it != _actionTable.end() && it->second.bQueued;
+}
+
+uint32_t NetworkManager::getNumQueuedOutputs()
+{
+	return _numQueuedOutputs;
 }
 
-uint32_t NetworkManager::getQueuedAgentId()
+const std::vector<float>& NetworkManager::popOutputBuffer(uint32_t agentId)
 {
-	return _queuedAgentId;
+	AgentAction& action = _actionTable[agentId];
+	if (action.bQueued) {
+		action.bQueued = false;
+		_numQueuedOutputs--;
+	}
+	return action.outputs;
 }
 
-const std::vector<float>& NetworkManager::popOutputBuffer()
+NetworkManager::Transport NetworkManager::getTransport()
 {
-	_bOutputQueued = false;
-	return _outputBuffer;
+	return _transport;
+}
+
+bool NetworkManager::isBatchingObservations()
+{
+	return _bBatchObservations && _transport == OSC;
+}
+
+bool NetworkManager::isAsyncIO()
+{
+	return _bAsyncIO;
 }
 
 BufferSender& NetworkManager::getBufferSender()
 {
 	return _bufferSender;
 }
+
+LatencyMonitor& NetworkManager::getLatencyMonitor()
+{
+	return _latencyMonitor;
+}
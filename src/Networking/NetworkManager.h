@@ -1,10 +1,16 @@
 #pragma once
 #include "BufferSender.h"
+#include "SharedMemoryChannel.h"
+#include "OscRouter.h"
+#include "NetworkIOThread.h"
+#include "FrameSender.h"
+#include "LatencyMonitor.h"
 #include "ofEvents.h"
 #include "ofEvent.h"
 #include "Utils/Scheduler.h"
 #include "Simulator/SimInstance.h"
 #include "Simulator/SimInfo.h"
+#include <unordered_map>
 
 class NetworkManager
 {
@@ -15,8 +21,14 @@ public:
 	ofEvent<void> onFitnessRequestReceived;
 	ofEvent<SimInfo> onInfoReceived;
 
-	void setup(std::string host, int inPort, int outPort);
-	void allocate(size_t numJoints, size_t numOutputs, uint32_t w, uint32_t h, ofPixelFormat type);
+	// Observations and actions go over OSC or through shared memory with a controller on the same machine.
+	// Control messages (handshake, info, rollout end, fitness) always use OSC.
+	enum Transport { OSC, SHM };
+
+	// Batched OSC observations are held back until flushObservations and go out as a single compressed frame.
+	// Async I/O receives and decodes OSC messages and sends joint states on threads of their own (see NetworkIOThread)
+	void setup(std::string host, int inPort, int outPort, Transport transport = OSC, std::string shmName = "neatures", bool bBatchObservations = false, bool bAsyncIO = false);
+	void allocate(size_t numJoints, size_t numOutputs, uint32_t w, uint32_t h, ofPixelFormat type, uint32_t numAgents = 1);
 	void search();
 
 	void send(std::string address);
@@ -25,36 +37,109 @@ public:
 	void send(std::string address, double arg);
 	void send(std::string address, const std::vector<double>& values);
 	void sendState(SimInstance* instance);
+
+	// Sends the observations batched since the last flush, call once per tick
+	void flushObservations();
+
+	// OSC conv patches compressed against the previous patch of an agent, with periodic keyframes
+	void setPatchStream(bool enable, uint32_t keyframeInterval = 30);
+
+	// The next patch of agentId is a keyframe, call when its rollout ends
+	void resetPatchStream(uint32_t agentId);
+
+	// OSC observations go out as single-datagram frames on /frm instead of /jnts and /art/ (see OscProtocol.h).
+	// Conv patches in these frames are compressed as in the patch stream when that is enabled
+	void setObservationFrames(bool enable);
+	bool isSendingFrames();
 	
 	void receive();
 
+	// Blocks until a message from the controller is waiting or timeoutMicros passed. Returns false right away
+	// without async I/O, messages are then only picked up by receive
+	bool waitForMessages(uint32_t timeoutMicros);
+
 	void close();
 
-	const std::vector<float>& popOutputBuffer();
-	bool isAgentOutputQueued();
-	uint32_t getQueuedAgentId();
+	// Actions are only accepted for agents between beginRollout and endRollout. endRollout also drops an unconsumed
+	// action, makes the next patch of the agent a keyframe and restarts its latency measurement
+	void beginRollout(uint32_t agentId);
+	void endRollout(uint32_t agentId);
+
+	// Actions are kept per agent (candidate id), so any number of them can be in flight and consumed in any order
+	const std::vector<float>& popOutputBuffer(uint32_t agentId);
+	bool isAgentOutputQueued(uint32_t agentId);
+	uint32_t getNumQueuedOutputs();
 
 	BufferSender& getBufferSender();
+	LatencyMonitor& getLatencyMonitor();
+	Transport getTransport();
+	bool isBatchingObservations();
+	bool isAsyncIO();
 
 private:
+	void queueAction(uint32_t agentId, const float* outputs, size_t size);
+
+	// Handles a message whose address was parsed into _address, returns false if receive should stop for this update
+	bool dispatch(int route, const float* values, size_t numValues, float arg);
+	void batchState(SimInstance* instance);
+	bool sendFrame(SimInstance* instance);
+
 	enum State { IDLE, HANDSHAKE, ACTIVE };
 	State _state = IDLE;
 
 	ofxOscSender _sender;
 	ofxOscReceiver _receiver;
 
+	// Incoming messages are dispatched on the first segment of their address, without splitting it into strings
+	enum Route { ROUTE_HELLO, ROUTE_INFO, ROUTE_BYE, ROUTE_ACTIVATION, ROUTE_PULSE, ROUTE_FITNESS };
+	OscRouter _router;
+	OscAddress _address;
+	ofxOscMessage _message;
+
+	bool _bAsyncIO = false;
+	NetworkIOThread _ioThread;
+	std::string _host;
+	int _inPort = 0;
+	int _outPort = 0;
+
 	// For sending large messages in compressed chunks like image data
 	BufferSender _bufferSender;
 
+	Transport _transport = OSC;
+	std::string _shmName;
+	SharedMemoryChannel _shmChannel;
+	std::vector<float> _shmActionBuffer;
+
 	ofEventListener _handshakeListener;
 	Scheduler _repeatMessageScheduler;
 
 	std::vector<float> _jointsInputBuffer;
 	size_t _jointsInputBufferSize = 16;
 
-	std::vector<float> _outputBuffer;
+	// observation batch, joint records and patches are kept apart and joined on flush (see OscProtocol.h)
+	bool _bBatchObservations = false;
+	std::vector<uint8_t> _batchJoints;
+	std::vector<uint8_t> _batchPatches;
+	std::vector<uint8_t> _batchBuffer;
+	std::unordered_map<uint32_t, uint32_t> _batchSlots;
+	uint32_t _batchSeq = 0;
+	uint32_t _patchWidth = 0;
+	uint32_t _patchHeight = 0;
+
+	// observation frames
+	bool _bObservationFrames = false;
+	FrameSender _frameSender;
+	std::vector<char> _framePayload;
+
+	struct AgentAction
+	{
+		std::vector<float> outputs;
+		bool bQueued = false;
+	};
+	std::unordered_map<uint32_t, AgentAction> _actionTable;
 	size_t _outputBufferSize = 16;
+	uint32_t _numQueuedOutputs = 0;
 
-	uint32_t _queuedAgentId = 0;
-	bool _bOutputQueued = false;
+	// Observation and action timing per agent, over every transport
+	LatencyMonitor _latencyMonitor;
 };
@@ -0,0 +1,303 @@
+#include "OscController.h"
+#include "OscProtocol.h"
+#include "ofxIniSettings.h"
+#include "lz4.h"
+
+OscController::~OscController()
+{
+	if (_dctx) {
+		LZ4F_freeDecompressionContext(_dctx);
+	}
+}
+
+int OscController::run()
+{
+	ofxIniSettings ini("settings.ini");
+	std::string host = ini.get("controller.host", "localhost");
+	_population = std::max(ini.get("evolution.max_parallel_sims", 1), 1);
+
+	if (LZ4F_isError(LZ4F_createDecompressionContext(&_dctx, LZ4F_VERSION))) {
+		ofLogError() << "[Controller] Could not create LZ4 decompression context";
+		return 1;
+	}
+	_router.add(OSC_HELLO_IN, ROUTE_HELLO);
+	_router.add(OSC_INFO_IN, ROUTE_INFO);
+	_router.add(OSC_BYE_IN, ROUTE_BYE);
+	_router.add(OSC_END, ROUTE_END);
+	_router.add(OSC_FITNESS_IN, ROUTE_FITNESS);
+	_router.add("jnts", ROUTE_JOINTS);
+	_router.add("art", ROUTE_ARTIFACT);
+	_router.add("ptch", ROUTE_PATCH);
+	_router.add("obs", ROUTE_OBSERVATIONS);
+	_router.add("frm", ROUTE_FRAME);
+
+	// Mirrors the simulator, which sends to controller.port and listens on controller.port_in
+	_receiver.setup(ini.get("controller.port", 1024));
+	_sender.setup(host, ini.get("controller.port_in", 1025));
+
+	ofLog() << "[Controller] Waiting for simulator on port " << ini.get("controller.port", 1024) << "...";
+
+	uint64_t reportStart = ofGetElapsedTimeMillis();
+	uint64_t reportActions = 0;
+
+	while (_bRunning) {
+		if (_receiver.hasWaitingMessages()) {
+			receive();
+		}
+		else {
+			ofSleepMillis(1);
+		}
+
+		uint64_t now = ofGetElapsedTimeMillis();
+		if (now - reportStart >= 1000) {
+			if (_bInfoReceived) {
+				ofLog() << "[Controller] actions/s: " << ofToString((_numActions - reportActions) * 1000.0 / (now - reportStart), 1) <<
+					" (generation " << _generation << ", decode errors " << _numDecodeErrors << ")";
+			}
+			reportStart = now;
+			reportActions = _numActions;
+		}
+	}
+	_receiver.stop();
+	return 0;
+}
+
+void OscController::receive()
+{
+	while (_bRunning && _receiver.hasWaitingMessages()) {
+		ofxOscMessage m;
+		_receiver.getNextMessage(m);
+
+		int route = _router.match(m.getAddress(), _address);
+		uint32_t id;
+
+		if (route == ROUTE_HELLO) {
+			// The simulator repeats its hello until it is answered
+			ofxOscMessage hello;
+			hello.setAddress(OSC_HELLO);
+			_sender.sendMessage(hello);
+		}
+		// /info/<genome>/<numJoints>/<numOutputs>/<convResolution>
+		if (route == ROUTE_INFO) {
+			uint32_t numOutputs = 0, convResolution = 0;
+			_address.toUInt(2, _numJoints);
+			_address.toUInt(3, numOutputs);
+			_address.toUInt(4, convResolution);
+
+			_joints.resize(_numJoints);
+			_outputs.resize(numOutputs);
+			_patchSize = convResolution * convResolution;
+			_patch.resize(_patchSize);
+			_ticks.resize(_population);
+			_active.resize(_population);
+			_actionBuffer.allocate(numOutputs * sizeof(float));
+
+			ofLog() << "[Controller] Simulator '" << _address.getString(1) << "': " << _numJoints << " joints, " << numOutputs << " outputs";
+			_bInfoReceived = true;
+			queueGeneration();
+		}
+		if (route == ROUTE_END && _address.toUInt(1, id)) {
+			if (id < _active.size() && _active[id]) {
+				_active[id] = false;
+				_patches.erase(id);
+				_frameDecoder.reset(id);
+
+				// The fitness of the whole generation is requested once its last rollout has ended
+				if (++_numFinished == _population) {
+					ofxOscMessage fitness;
+					fitness.setAddress(OSC_FITNESS);
+					_sender.sendMessage(fitness);
+				}
+			}
+		}
+		// /fit/<numEntries>/<numStats> followed by the flattened stats
+		if (route == ROUTE_FITNESS) {
+			_generation++;
+			queueGeneration();
+		}
+		if (route == ROUTE_BYE) {
+			_bRunning = false;
+		}
+
+		// Observations, the agent id arrives with the patch that follows the joints
+		if (route == ROUTE_JOINTS && m.getNumArgs() > 0 && !_joints.empty()) {
+			const ofBuffer& blob = m.getArgAsBlob(0);
+			memcpy(&_joints[0], blob.getData(), std::min(blob.size(), _joints.size() * sizeof(float)));
+		}
+		if (route == ROUTE_ARTIFACT && receiveParts(_artifactParts, m, id)) {
+			receiveArtifact(id);
+		}
+		if (route == ROUTE_PATCH && receiveParts(_patchParts, m, id)) {
+			receivePatch(id);
+		}
+		if (route == ROUTE_OBSERVATIONS && receiveParts(_observationParts, m, id)) {
+			receiveObservations();
+		}
+		if (route == ROUTE_FRAME) {
+			receiveFrame(m);
+		}
+	}
+}
+
+bool OscController::receiveParts(std::vector<uint8_t>& parts, const ofxOscMessage& m, uint32_t& id)
+{
+	if (_address.equals(1, OSC_START)) {
+		parts.clear();
+	}
+	else if (_address.equals(1, OSC_PART) && m.getNumArgs() > 0) {
+		const ofBuffer& blob = m.getArgAsBlob(0);
+		parts.insert(parts.end(), blob.getData(), blob.getData() + blob.size());
+	}
+	else if (_address.equals(1, OSC_END) && m.getNumArgs() > 0) {
+		id = uint32_t(m.getArgAsInt32(0));
+		return true;
+	}
+	return false;
+}
+
+void OscController::receiveArtifact(uint32_t agentId)
+{
+	if (!decompressFrame(_artifactParts, _decoded) || _decoded.size() != _patchSize) {
+		_numDecodeErrors++;
+	}
+	// A lost part only costs the patch, the agent still needs its action to go on
+	act(agentId);
+}
+
+void OscController::receivePatch(uint32_t agentId)
+{
+	const std::vector<uint8_t>& data = _patchParts;
+	std::vector<uint8_t>& previous = _patches[agentId];
+
+	int decoded = -1;
+	if (data.size() > OSC_PATCH_HEADER_SIZE && _patchSize > 0) {
+		const char* block = reinterpret_cast<const char*>(&data[OSC_PATCH_HEADER_SIZE]);
+		int blockSize = int(data.size() - OSC_PATCH_HEADER_SIZE);
+
+		if (data[0] == OSC_PATCH_DELTA && previous.size() == _patchSize) {
+			decoded = LZ4_decompress_safe_usingDict(block, reinterpret_cast<char*>(&_patch[0]), blockSize, int(_patchSize),
+				reinterpret_cast<const char*>(&previous[0]), int(_patchSize));
+		}
+		else if (data[0] == OSC_PATCH_KEYFRAME) {
+			decoded = LZ4_decompress_safe(block, reinterpret_cast<char*>(&_patch[0]), blockSize, int(_patchSize));
+		}
+	}
+	if (decoded == int(_patchSize)) {
+		previous = _patch;
+	}
+	else {
+		// Deltas cannot be resolved until the next keyframe
+		previous.clear();
+		_numDecodeErrors++;
+	}
+	act(agentId);
+}
+
+void OscController::receiveObservations()
+{
+	const size_t headerSize = 4 * sizeof(uint32_t);
+	if (!decompressFrame(_observationParts, _decoded) || _decoded.size() < headerSize) {
+		_numDecodeErrors++;
+		return;
+	}
+	uint32_t header[4];
+	memcpy(header, &_decoded[0], headerSize);
+
+	uint32_t numAgents = header[0];
+	size_t recordSize = sizeof(uint32_t) + header[1] * sizeof(float);
+	if (_decoded.size() < headerSize + numAgents * (recordSize + size_t(header[2]) * header[3])) {
+		_numDecodeErrors++;
+		return;
+	}
+	for (uint32_t i = 0; i < numAgents; i++) {
+		uint32_t agentId;
+		memcpy(&agentId, &_decoded[headerSize + i * recordSize], sizeof(uint32_t));
+		act(agentId);
+	}
+}
+
+void OscController::receiveFrame(const ofxOscMessage& m)
+{
+	if (m.getNumArgs() == 0) {
+		return;
+	}
+	const ofBuffer& blob = m.getArgAsBlob(0);
+
+	FrameDecoder::Frame frame;
+	if (!_frameDecoder.decode(reinterpret_cast<const uint8_t*>(blob.getData()), blob.size(), frame)) {
+		_numDecodeErrors++;
+		ofLogWarning() << "[Controller] Could not decode frame: " << _frameDecoder.getError();
+
+		// Without a readable header there is no agent to answer
+		if (!frame.bHeaderValid) {
+			return;
+		}
+	}
+	// A lost or corrupt patch only costs the patch, the agent still needs its action to go on
+	act(frame.agentId);
+}
+
+bool OscController::decompressFrame(const std::vector<uint8_t>& src, std::vector<uint8_t>& dst)
+{
+	if (src.empty()) {
+		return false;
+	}
+	LZ4F_resetDecompressionContext(_dctx);
+	dst.resize(std::max(dst.capacity(), src.size() * 4));
+
+	size_t srcPos = 0, dstPos = 0;
+	for (;;) {
+		if (dstPos == dst.size()) {
+			dst.resize(dst.size() * 2);
+		}
+		size_t srcSize = src.size() - srcPos;
+		size_t dstSize = dst.size() - dstPos;
+		size_t result = LZ4F_decompress(_dctx, &dst[dstPos], &dstSize, &src[srcPos], &srcSize, nullptr);
+		if (LZ4F_isError(result)) {
+			return false;
+		}
+		srcPos += srcSize;
+		dstPos += dstSize;
+
+		if (result == 0) {
+			dst.resize(dstPos);
+			return true;
+		}
+		// Truncated frame
+		if (srcSize == 0 && dstSize == 0) {
+			return false;
+		}
+	}
+}
+
+void OscController::queueGeneration()
+{
+	_numFinished = 0;
+	std::fill(_ticks.begin(), _ticks.end(), 0);
+	std::fill(_active.begin(), _active.end(), true);
+
+	for (uint32_t i = 0; i < _population; i++) {
+		ofxOscMessage info;
+		info.setAddress(OSC_INFO + "/standin/" + ofToString(i) + '/' + ofToString(_generation) + '/' + ofToString(_duration));
+		_sender.sendMessage(info);
+	}
+}
+
+void OscController::act(uint32_t agentId)
+{
+	if (agentId >= _active.size() || !_active[agentId] || _outputs.empty()) {
+		return;
+	}
+	// Travelling wave over the joints, the brush pressure output follows the first joint
+	float phase = _ticks[agentId]++ * 0.2f;
+	for (size_t i = 0; i < _outputs.size(); i++) {
+		_outputs[i] = std::sin(phase + i * 0.5f);
+	}
+	_actionBuffer.set(reinterpret_cast<const char*>(&_outputs[0]), _outputs.size() * sizeof(float));
+
+	ofxOscMessage action;
+	action.setAddress('/' + OSC_ACTIVATION + '/' + ofToString(agentId));
+	action.addBlobArg(_actionBuffer);
+	_sender.sendMessage(action);
+	_numActions++;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "OscRouter.h"
+#include "FrameDecoder.h"
+#include "ofxOsc.h"
+#include "lz4frame.h"
+#include <unordered_map>
+
+// Stand-in for the evolution module over the OSC transport, to benchmark the control loop without it.
+// Runs as its own process (neatures --osc-controller), answers the handshake, queues a population of candidates
+// every generation, requests its fitness when all rollouts have ended and replies to each observation with a
+// sinusoidal effector vector on /act. Decodes every observation format the simulator can send: /jnts with /art/,
+// /ptch/, /obs/ and /frm. oscpack drops datagrams larger than its receive buffer, so large raw frames need
+// patch_stream to be compressed.
+class OscController
+{
+public:
+	~OscController();
+
+	int run();
+
+private:
+	enum Route { ROUTE_HELLO, ROUTE_INFO, ROUTE_BYE, ROUTE_END, ROUTE_FITNESS, ROUTE_JOINTS, ROUTE_ARTIFACT, ROUTE_PATCH, ROUTE_OBSERVATIONS, ROUTE_FRAME };
+
+	void receive();
+	// Collects a buffer sent in parts on /art/, /ptch/ or /obs/, true with the id of its end message once complete
+	bool receiveParts(std::vector<uint8_t>& parts, const ofxOscMessage& m, uint32_t& id);
+	void receiveArtifact(uint32_t agentId);
+	void receivePatch(uint32_t agentId);
+	void receiveObservations();
+	void receiveFrame(const ofxOscMessage& m);
+
+	bool decompressFrame(const std::vector<uint8_t>& src, std::vector<uint8_t>& dst);
+
+	void queueGeneration();
+	void act(uint32_t agentId);
+
+	ofxOscSender _sender;
+	ofxOscReceiver _receiver;
+	OscRouter _router;
+	OscAddress _address;
+
+	uint32_t _population = 1;
+	uint32_t _duration = 10;
+	uint32_t _generation = 0;
+	uint32_t _numFinished = 0;
+
+	uint32_t _numJoints = 0;
+	uint32_t _patchSize = 0;
+
+	std::vector<float> _joints;
+	std::vector<float> _outputs;
+	std::vector<uint8_t> _patch;
+	std::vector<uint8_t> _decoded;
+	std::vector<uint32_t> _ticks;
+	std::vector<bool> _active;
+
+	std::vector<uint8_t> _artifactParts;
+	std::vector<uint8_t> _patchParts;
+	std::vector<uint8_t> _observationParts;
+
+	// Last patch of every agent, the dictionary of its next delta patch
+	std::unordered_map<uint32_t, std::vector<uint8_t>> _patches;
+	FrameDecoder _frameDecoder;
+	LZ4F_dctx* _dctx = nullptr;
+
+	ofBuffer _actionBuffer;
+
+	uint64_t _numActions = 0;
+	uint64_t _numDecodeErrors = 0;
+	bool _bInfoReceived = false;
+	bool _bRunning = true;
+};
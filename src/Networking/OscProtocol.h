@@ -16,6 +16,49 @@ const std::string OSC_ARTIFACT_PART = "/art/part/";
 const std::string OSC_ARTIFACT_END = "/art/end/";
 const std::string OSC_ARTIFACT_INFO = "/art/info/";
 
+// Patch stream: conv images of an agent sent in parts like artifacts, the end message carries the agent id.
+// Payload: uint8 type, then an LZ4 block (not a frame) of width * height bytes. Delta blocks are compressed with the
+// previous patch of the same agent as dictionary (LZ4_decompress_safe_usingDict), keyframes without one.
+// The first patch of a rollout is a keyframe
+const std::string OSC_PATCH_START = "/ptch/start/";
+const std::string OSC_PATCH_PART = "/ptch/part/";
+const std::string OSC_PATCH_END = "/ptch/end/";
+
+const char OSC_PATCH_KEYFRAME = 0;
+const char OSC_PATCH_DELTA = 1;
+const size_t OSC_PATCH_HEADER_SIZE = 1;
+
+// Batched observations: every observation of a tick in a single LZ4 frame, sent in parts like artifacts.
+// The end message carries the batch number. Decompressed layout (little-endian):
+//   uint32 numAgents, uint32 numJoints, uint32 width, uint32 height
+//   numAgents x { uint32 agentId, float joints[numJoints] }
+//   numAgents x uint8 patch[width * height], in the order of the joint records
+const std::string OSC_OBSERVATIONS_START = "/obs/start/";
+const std::string OSC_OBSERVATIONS_PART = "/obs/part/";
+const std::string OSC_OBSERVATIONS_END = "/obs/end/";
+
+// Observation frames: the joint state and conv patch of one agent in a single datagram, sent as an OSC message with
+// a single blob argument, so any OSC receiver accepts it. Blob layout (little-endian, version 1):
+//   uint32 magic, uint16 version, uint16 flags
+//   uint32 agentId, uint32 tick (actions applied in the rollout so far)
+//   uint16 numJoints, uint16 width, uint16 height, uint16 reserved
+//   uint32 payloadSize
+//   float joints[numJoints]
+//   uint8 payload[payloadSize]: the patch of width * height bytes, raw or as an LZ4 block (see flags)
+// A receiver should drop frames with a version it does not know. FrameDecoder is a reference implementation
+const std::string OSC_FRAME = "/frm";
+
+const uint32_t FRAME_MAGIC = 0x5246544e; // "NTFR"
+const uint16_t FRAME_VERSION = 1;
+const size_t FRAME_HEADER_SIZE = 28;
+
+// Payload is an LZ4 block, and with FRAME_DELTA compressed with the previous patch of the agent as dictionary
+const uint16_t FRAME_LZ4 = 1 << 0;
+const uint16_t FRAME_DELTA = 1 << 1;
+
+// Largest UDP payload over IPv4
+const size_t FRAME_MAX_DATAGRAM = 65507;
+
 // receive
 const std::string OSC_HELLO_IN = "hi";
 const std::string OSC_INFO_IN = "info";
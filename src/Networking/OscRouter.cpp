@@ -0,0 +1,144 @@
+#include "OscRouter.h"
+#include <algorithm>
+#include <cstring>
+#include <climits>
+
+uint32_t OscAddress::hash(const char* str, size_t len)
+{
+	// FNV-1a
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		h ^= uint8_t(str[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+bool OscAddress::parse(const std::string& address)
+{
+	return parse(address.c_str(), address.size());
+}
+
+bool OscAddress::parse(const char* address, size_t size)
+{
+	_address = address;
+	_numSegments = 0;
+
+	size = std::min(size, size_t(UINT16_MAX));
+	size_t begin = (size > 0 && _address[0] == '/') ? 1 : 0;
+
+	while (begin <= size) {
+		if (_numSegments == MAX_SEGMENTS) {
+			return false;
+		}
+		const char* end = static_cast<const char*>(memchr(_address + begin, '/', size - begin));
+		size_t length = end ? size_t(end - _address) - begin : size - begin;
+
+		_begin[_numSegments] = uint16_t(begin);
+		_length[_numSegments] = uint16_t(length);
+		_hash[_numSegments] = hash(_address + begin, length);
+		_numSegments++;
+
+		begin += length + 1;
+	}
+	return true;
+}
+
+size_t OscAddress::getNumSegments() const
+{
+	return _numSegments;
+}
+
+uint32_t OscAddress::getHash(size_t segment) const
+{
+	return _hash[segment];
+}
+
+bool OscAddress::equals(size_t segment, const std::string& str) const
+{
+	return segment < _numSegments && _length[segment] == str.size() &&
+		memcmp(_address + _begin[segment], str.c_str(), str.size()) == 0;
+}
+
+bool OscAddress::toInt(size_t segment, int& value) const
+{
+	if (segment >= _numSegments || _length[segment] == 0) {
+		return false;
+	}
+	bool bNegative = _address[_begin[segment]] == '-';
+	uint64_t v;
+	if (!parseDigits(_address + _begin[segment] + (bNegative ? 1 : 0), _length[segment] - (bNegative ? 1 : 0), INT_MAX, v)) {
+		return false;
+	}
+	value = bNegative ? -int(v) : int(v);
+	return true;
+}
+
+bool OscAddress::toUInt(size_t segment, uint32_t& value) const
+{
+	if (segment >= _numSegments) {
+		return false;
+	}
+	uint64_t v;
+	if (!parseDigits(_address + _begin[segment], _length[segment], UINT32_MAX, v)) {
+		return false;
+	}
+	value = uint32_t(v);
+	return true;
+}
+
+bool OscAddress::parseDigits(const char* str, size_t len, uint64_t max, uint64_t& value)
+{
+	if (len == 0) {
+		return false;
+	}
+	value = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (str[i] < '0' || str[i] > '9') {
+			return false;
+		}
+		value = value * 10 + uint64_t(str[i] - '0');
+		if (value > max) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string OscAddress::getString(size_t segment) const
+{
+	if (segment >= _numSegments) {
+		return std::string();
+	}
+	return std::string(_address + _begin[segment], _length[segment]);
+}
+
+void OscRouter::add(const std::string& segment, int route)
+{
+	_entries.push_back({ OscAddress::hash(segment.c_str(), segment.size()), segment, route });
+}
+
+void OscRouter::clear()
+{
+	_entries.clear();
+}
+
+int OscRouter::match(const std::string& address, OscAddress& parsed) const
+{
+	return match(address.c_str(), address.size(), parsed);
+}
+
+int OscRouter::match(const char* address, size_t size, OscAddress& parsed) const
+{
+	parsed.parse(address, size);
+	if (parsed.getNumSegments() == 0) {
+		return NO_ROUTE;
+	}
+	uint32_t h = parsed.getHash(0);
+	for (const Entry& entry : _entries) {
+		if (entry.hash == h && parsed.equals(0, entry.segment)) {
+			return entry.route;
+		}
+	}
+	return NO_ROUTE;
+}
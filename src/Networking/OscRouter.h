@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Segments of an OSC address as offsets into the address itself, so nothing is copied or allocated while matching.
+// Segment 0 is the part after the leading slash: "/act/12" has segments "act" and "12".
+// The address must stay alive and unchanged while it is read.
+class OscAddress
+{
+public:
+	static const size_t MAX_SEGMENTS = 8;
+
+	// Returns false if the address has more than MAX_SEGMENTS segments, the first MAX_SEGMENTS are kept
+	bool parse(const std::string& address);
+	bool parse(const char* address, size_t size);
+
+	size_t getNumSegments() const;
+	uint32_t getHash(size_t segment) const;
+
+	bool equals(size_t segment, const std::string& str) const;
+
+	// Parses a decimal integer segment, returns false if it is missing, not a number or out of range
+	bool toInt(size_t segment, int& value) const;
+	bool toUInt(size_t segment, uint32_t& value) const;
+
+	// Allocates, meant for the rare string arguments like the ga id of an info message
+	std::string getString(size_t segment) const;
+
+	static uint32_t hash(const char* str, size_t len);
+
+private:
+	static bool parseDigits(const char* str, size_t len, uint64_t max, uint64_t& value);
+
+	const char* _address = nullptr;
+	uint16_t _begin[MAX_SEGMENTS];
+	uint16_t _length[MAX_SEGMENTS];
+	uint32_t _hash[MAX_SEGMENTS];
+	size_t _numSegments = 0;
+};
+
+// Maps the first segment of an OSC address to a route id. The segments are hashed once when added, a message then
+// costs one hash and a compare per route instead of splitting its address into strings.
+class OscRouter
+{
+public:
+	static const int NO_ROUTE = -1;
+
+	void add(const std::string& segment, int route);
+	void clear();
+
+	// Parses address and returns the route of its first segment or NO_ROUTE
+	int match(const std::string& address, OscAddress& parsed) const;
+	int match(const char* address, size_t size, OscAddress& parsed) const;
+
+private:
+	struct Entry
+	{
+		uint32_t hash;
+		std::string segment;
+		int route;
+	};
+	std::vector<Entry> _entries;
+};
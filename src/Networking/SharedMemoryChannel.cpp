@@ -0,0 +1,531 @@
+#include "SharedMemoryChannel.h"
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory atomics must be lock free");
+
+namespace
+{
+	size_t alignUp(size_t size, size_t alignment)
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	uint32_t nextPowerOfTwo(uint32_t v)
+	{
+		uint32_t p = 1;
+		while (p < v) {
+			p <<= 1;
+		}
+		return p;
+	}
+
+	// Each agent has at most one observation in flight, the extra room covers stale entries of a released slot
+	uint32_t ringCapacity(uint32_t numSlots)
+	{
+		return nextPowerOfTwo(numSlots * 2);
+	}
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+	close();
+}
+
+size_t SharedMemoryChannel::headerSize()
+{
+	return alignUp(sizeof(Header), 64);
+}
+
+size_t SharedMemoryChannel::actionStride(uint32_t numOutputs)
+{
+	return alignUp(sizeof(Entry) + numOutputs * sizeof(float), 8);
+}
+
+size_t SharedMemoryChannel::slotStride(uint32_t numJoints, uint32_t convWidth, uint32_t convHeight)
+{
+	return alignUp(sizeof(Slot) + numJoints * sizeof(float) + size_t(convWidth) * convHeight, 64);
+}
+
+bool SharedMemoryChannel::create(const std::string& name, uint32_t numSlots, uint32_t numJoints, uint32_t numOutputs, uint32_t convWidth, uint32_t convHeight)
+{
+	close();
+
+	uint32_t capacity = ringCapacity(numSlots);
+	size_t stride = slotStride(numJoints, convWidth, convHeight);
+	size_t ringsSize = alignUp(capacity * sizeof(Entry), 64) + alignUp(capacity * actionStride(numOutputs), 64);
+	size_t size = headerSize() + ringsSize + numSlots * stride;
+
+	if (!map(name, size, true)) {
+		return false;
+	}
+	std::memset(_data, 0, size);
+
+	_header = new (_data) Header();
+	_header->magic = magic;
+	_header->version = version;
+	_header->numSlots = numSlots;
+	_header->numJoints = numJoints;
+	_header->numOutputs = numOutputs;
+	_header->convWidth = convWidth;
+	_header->convHeight = convHeight;
+	_header->ringCapacity = capacity;
+	_header->actionStride = uint32_t(actionStride(numOutputs));
+	_header->slotStride = uint32_t(stride);
+
+	for (uint32_t i = 0; i < numSlots; i++) {
+		new (_data + headerSize() + ringsSize + i * stride) Slot();
+	}
+
+	// Handed out from the back, so the lowest slots are used first
+	_freeSlots.clear();
+	for (uint32_t i = numSlots; i > 0; i--) {
+		_freeSlots.push_back(i - 1);
+	}
+
+	// Published last, the controller refuses to attach before this is set
+	_header->bReady.store(1, std::memory_order_release);
+	return true;
+}
+
+bool SharedMemoryChannel::open(const std::string& name)
+{
+	close();
+
+	if (!map(name, 0, false)) {
+		return false;
+	}
+	_header = reinterpret_cast<Header*>(_data);
+
+	if (_size < headerSize() || !_header->bReady.load(std::memory_order_acquire) ||
+		_header->magic != magic || _header->version != version) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void SharedMemoryChannel::close()
+{
+	if (_data) {
+		unmap();
+	}
+	_header = nullptr;
+	_data = nullptr;
+	_size = 0;
+	_bOwner = false;
+	_agentSlots.clear();
+	_freeSlots.clear();
+}
+
+bool SharedMemoryChannel::isOpen() const
+{
+	return _header != nullptr;
+}
+
+bool SharedMemoryChannel::acquireSlot(uint32_t agentId)
+{
+	// A candidate id that is queued again starts over in a slot of its own
+	releaseSlot(agentId);
+
+	if (_freeSlots.empty()) {
+		return false;
+	}
+	uint32_t index = _freeSlots.back();
+	_freeSlots.pop_back();
+
+	Slot* s = slot(index);
+	setRollout(s, agentId, s->rollout + 1);
+	_agentSlots[agentId] = { index, s->rollout };
+	return true;
+}
+
+void SharedMemoryChannel::releaseSlot(uint32_t agentId)
+{
+	auto it = _agentSlots.find(agentId);
+	if (it == _agentSlots.end()) {
+		return;
+	}
+	// Entries still in the rings for this rollout no longer match the slot
+	Slot* s = slot(it->second.slot);
+	setRollout(s, agentId, s->rollout + 1);
+
+	_freeSlots.push_back(it->second.slot);
+	_agentSlots.erase(it);
+}
+
+void SharedMemoryChannel::setRollout(Slot* s, uint32_t agentId, uint32_t rollout)
+{
+	uint32_t seq = s->sequence.load(std::memory_order_relaxed);
+	s->sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	s->agentId = agentId;
+	s->rollout = rollout;
+
+	s->sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool SharedMemoryChannel::writeObservation(uint32_t agentId, const float* joints, const uint8_t* convPixels)
+{
+	auto it = _agentSlots.find(agentId);
+	if (it == _agentSlots.end()) {
+		return false;
+	}
+	uint8_t* entry = beginPush(observationRing(), sizeof(Entry), _header->observationHead, _header->observationTail);
+	if (!entry) {
+		return false;
+	}
+	Slot* s = slot(it->second.slot);
+
+	// Seqlock, the controller retries if it reads while the slot is being written
+	uint32_t seq = s->sequence.load(std::memory_order_relaxed);
+	s->sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	std::memcpy(slotJoints(s), joints, _header->numJoints * sizeof(float));
+	std::memcpy(slotConvPixels(s), convPixels, size_t(_header->convWidth) * _header->convHeight);
+
+	s->sequence.store(seq + 2, std::memory_order_release);
+
+	const Entry e = { it->second.slot, it->second.rollout };
+	std::memcpy(entry, &e, sizeof(Entry));
+	commitPush(_header->observationHead);
+
+	signal(_header->observationSignal, _observationEvent);
+	return true;
+}
+
+bool SharedMemoryChannel::readObservation(uint32_t& agentId, float* joints, uint8_t* convPixels)
+{
+	while (const uint8_t* entry = front(observationRing(), sizeof(Entry), _header->observationHead, _header->observationTail)) {
+		Entry e;
+		std::memcpy(&e, entry, sizeof(Entry));
+		pop(_header->observationTail);
+
+		if (e.slot >= _header->numSlots) {
+			continue;
+		}
+		Slot* s = slot(e.slot);
+
+		uint32_t seq, id, rollout;
+		do {
+			seq = s->sequence.load(std::memory_order_acquire);
+			if (seq & 1) {
+				continue;
+			}
+			id = s->agentId;
+			rollout = s->rollout;
+			std::memcpy(joints, slotJoints(s), _header->numJoints * sizeof(float));
+			std::memcpy(convPixels, slotConvPixels(s), size_t(_header->convWidth) * _header->convHeight);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while ((seq & 1) || s->sequence.load(std::memory_order_relaxed) != seq);
+
+		// The rollout has released the slot since, a newer owner has entries of its own further on
+		if (rollout == e.rollout) {
+			_agentSlots[id] = { e.slot, e.rollout };
+			agentId = id;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SharedMemoryChannel::writeAction(uint32_t agentId, const float* outputs)
+{
+	auto it = _agentSlots.find(agentId);
+	if (it == _agentSlots.end()) {
+		return false;
+	}
+	uint8_t* entry = beginPush(actionRing(), _header->actionStride, _header->actionHead, _header->actionTail);
+	if (!entry) {
+		return false;
+	}
+	// The outputs travel in the ring, so a stale action never overwrites those of the next owner of the slot
+	const Entry e = { it->second.slot, it->second.rollout };
+	std::memcpy(entry, &e, sizeof(Entry));
+	std::memcpy(entry + sizeof(Entry), outputs, _header->numOutputs * sizeof(float));
+	commitPush(_header->actionHead);
+
+	signal(_header->actionSignal, _actionEvent);
+	return true;
+}
+
+bool SharedMemoryChannel::readAction(uint32_t& agentId, float* outputs)
+{
+	while (const uint8_t* entry = front(actionRing(), _header->actionStride, _header->actionHead, _header->actionTail)) {
+		Entry e;
+		std::memcpy(&e, entry, sizeof(Entry));
+
+		// Only the simulator writes slot ownership, so it is read without the seqlock
+		bool bCurrent = e.slot < _header->numSlots && slot(e.slot)->rollout == e.rollout;
+		if (bCurrent) {
+			std::memcpy(outputs, entry + sizeof(Entry), _header->numOutputs * sizeof(float));
+			agentId = slot(e.slot)->agentId;
+		}
+		pop(_header->actionTail);
+
+		if (bCurrent) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SharedMemoryChannel::waitForObservation(uint32_t timeoutMillis)
+{
+	return wait(_header->observationSignal, _header->observationHead, _header->observationTail, _observationEvent, timeoutMillis);
+}
+
+bool SharedMemoryChannel::waitForAction(uint32_t timeoutMillis)
+{
+	return wait(_header->actionSignal, _header->actionHead, _header->actionTail, _actionEvent, timeoutMillis);
+}
+
+uint8_t* SharedMemoryChannel::observationRing() const
+{
+	return _data + headerSize();
+}
+
+uint8_t* SharedMemoryChannel::actionRing() const
+{
+	return observationRing() + alignUp(_header->ringCapacity * sizeof(Entry), 64);
+}
+
+SharedMemoryChannel::Slot* SharedMemoryChannel::slot(uint32_t index) const
+{
+	uint8_t* slots = actionRing() + alignUp(size_t(_header->ringCapacity) * _header->actionStride, 64);
+	return reinterpret_cast<Slot*>(slots + index * _header->slotStride);
+}
+
+float* SharedMemoryChannel::slotJoints(Slot* s) const
+{
+	return reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(s) + sizeof(Slot));
+}
+
+uint8_t* SharedMemoryChannel::slotConvPixels(Slot* s) const
+{
+	return reinterpret_cast<uint8_t*>(slotJoints(s) + _header->numJoints);
+}
+
+uint8_t* SharedMemoryChannel::beginPush(uint8_t* ring, size_t stride, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail)
+{
+	uint32_t h = head.load(std::memory_order_relaxed);
+	if (h - tail.load(std::memory_order_acquire) >= _header->ringCapacity) {
+		return nullptr;
+	}
+	return ring + (h & (_header->ringCapacity - 1)) * stride;
+}
+
+void SharedMemoryChannel::commitPush(std::atomic<uint32_t>& head)
+{
+	head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+const uint8_t* SharedMemoryChannel::front(const uint8_t* ring, size_t stride, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail) const
+{
+	uint32_t t = tail.load(std::memory_order_relaxed);
+	if (t == head.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+	return ring + (t & (_header->ringCapacity - 1)) * stride;
+}
+
+void SharedMemoryChannel::pop(std::atomic<uint32_t>& tail)
+{
+	tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint32_t SharedMemoryChannel::getNumSlots() const
+{
+	return _header->numSlots;
+}
+
+uint32_t SharedMemoryChannel::getNumJoints() const
+{
+	return _header->numJoints;
+}
+
+uint32_t SharedMemoryChannel::getNumOutputs() const
+{
+	return _header->numOutputs;
+}
+
+uint32_t SharedMemoryChannel::getConvWidth() const
+{
+	return _header->convWidth;
+}
+
+uint32_t SharedMemoryChannel::getConvHeight() const
+{
+	return _header->convHeight;
+}
+
+#ifdef _WIN32
+
+bool SharedMemoryChannel::map(const std::string& name, size_t size, bool bCreate)
+{
+	std::string mappingName = "Local\\" + name;
+	HANDLE mapping = bCreate ?
+		CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, DWORD(uint64_t(size) >> 32), DWORD(size), mappingName.c_str()) :
+		OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str());
+	if (!mapping) {
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!view) {
+		CloseHandle(mapping);
+		return false;
+	}
+	if (!bCreate) {
+		MEMORY_BASIC_INFORMATION info;
+		VirtualQuery(view, &info, sizeof(info));
+		size = info.RegionSize;
+	}
+
+	// Named auto-reset events stand in for futexes, which do not work across processes on Windows
+	_observationEvent = CreateEventA(NULL, FALSE, FALSE, (mappingName + "_obs").c_str());
+	_actionEvent = CreateEventA(NULL, FALSE, FALSE, (mappingName + "_act").c_str());
+
+	_name = name;
+	_mapping = mapping;
+	_data = static_cast<uint8_t*>(view);
+	_size = size;
+	_bOwner = bCreate;
+	return true;
+}
+
+void SharedMemoryChannel::unmap()
+{
+	UnmapViewOfFile(_data);
+	CloseHandle(static_cast<HANDLE>(_mapping));
+	if (_observationEvent) CloseHandle(static_cast<HANDLE>(_observationEvent));
+	if (_actionEvent) CloseHandle(static_cast<HANDLE>(_actionEvent));
+	_mapping = nullptr;
+	_observationEvent = nullptr;
+	_actionEvent = nullptr;
+}
+
+void SharedMemoryChannel::signal(std::atomic<uint32_t>& word, void* event)
+{
+	word.fetch_add(1, std::memory_order_release);
+	SetEvent(static_cast<HANDLE>(event));
+}
+
+bool SharedMemoryChannel::wait(std::atomic<uint32_t>& word, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail, void* event, uint32_t timeoutMillis)
+{
+	if (head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed)) {
+		return true;
+	}
+	WaitForSingleObject(static_cast<HANDLE>(event), timeoutMillis);
+	return head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool SharedMemoryChannel::map(const std::string& name, size_t size, bool bCreate)
+{
+	std::string shmName = "/" + name;
+	int fd = bCreate ?
+		shm_open(shmName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600) :
+		shm_open(shmName.c_str(), O_RDWR, 0600);
+	if (fd < 0) {
+		return false;
+	}
+
+	if (bCreate) {
+		if (ftruncate(fd, size) != 0) {
+			::close(fd);
+			shm_unlink(shmName.c_str());
+			return false;
+		}
+	}
+	else {
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			::close(fd);
+			return false;
+		}
+		size = st.st_size;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		::close(fd);
+		if (bCreate) {
+			shm_unlink(shmName.c_str());
+		}
+		return false;
+	}
+
+	_name = name;
+	_fd = fd;
+	_data = static_cast<uint8_t*>(view);
+	_size = size;
+	_bOwner = bCreate;
+	return true;
+}
+
+void SharedMemoryChannel::unmap()
+{
+	munmap(_data, _size);
+	::close(_fd);
+	_fd = -1;
+
+	if (_bOwner) {
+		shm_unlink(("/" + _name).c_str());
+	}
+}
+
+void SharedMemoryChannel::signal(std::atomic<uint32_t>& word, void* event)
+{
+	word.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+	// Shared (not private) futex, the waiter lives in another process
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+bool SharedMemoryChannel::wait(std::atomic<uint32_t>& word, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail, void* event, uint32_t timeoutMillis)
+{
+	// Read the signal word before checking the ring so a push in between wakes us up
+	uint32_t seen = word.load(std::memory_order_acquire);
+	if (head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed)) {
+		return true;
+	}
+#ifdef __linux__
+	struct timespec timeout;
+	timeout.tv_sec = timeoutMillis / 1000;
+	timeout.tv_nsec = (timeoutMillis % 1000) * 1000000;
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+#else
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+	while (word.load(std::memory_order_acquire) == seen && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+#endif
+	return head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Observation/action transport for a controller running on the same machine.
+// A single shared memory region holds one slot per running agent (joint state and conv pixels) and two
+// single-producer/single-consumer rings: slot references that announce new observations, and actions that carry
+// their outputs. The simulator hands out slots explicitly for the length of a rollout (acquireSlot/releaseSlot).
+// Every ring entry names the slot and the rollout it was written for, so entries of an agent whose slot has
+// changed hands since are dropped instead of being read as, or applied to, the new owner.
+// The simulator creates the region, the controller opens it by name. Only plain data lives in the region so it
+// can be read by any process.
+class SharedMemoryChannel
+{
+public:
+	~SharedMemoryChannel();
+
+	// Simulator side
+	bool create(const std::string& name, uint32_t numSlots, uint32_t numJoints, uint32_t numOutputs, uint32_t convWidth, uint32_t convHeight);
+
+	// Gives agentId a slot of its own until releaseSlot, returns false if all slots are taken
+	bool acquireSlot(uint32_t agentId);
+	void releaseSlot(uint32_t agentId);
+
+	// Fails for agents without a slot or when the ring is full
+	bool writeObservation(uint32_t agentId, const float* joints, const uint8_t* convPixels);
+
+	// Skips actions for rollouts that have released their slot since
+	bool readAction(uint32_t& agentId, float* outputs);
+
+	// Controller side
+	bool open(const std::string& name);
+	bool readObservation(uint32_t& agentId, float* joints, uint8_t* convPixels);
+
+	// Answers the last observation read of agentId, fails if none was read or the ring is full
+	bool writeAction(uint32_t agentId, const float* outputs);
+
+	// Blocks until the ring is non-empty or the timeout expires, returns true if there is something to read
+	bool waitForObservation(uint32_t timeoutMillis);
+	bool waitForAction(uint32_t timeoutMillis);
+
+	void close();
+	bool isOpen() const;
+
+	uint32_t getNumSlots() const;
+	uint32_t getNumJoints() const;
+	uint32_t getNumOutputs() const;
+	uint32_t getConvWidth() const;
+	uint32_t getConvHeight() const;
+
+	static const uint32_t magic = 0x5352544e; // "NTRS"
+	static const uint32_t version = 2;
+
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numSlots;
+		uint32_t numJoints;
+		uint32_t numOutputs;
+		uint32_t convWidth;
+		uint32_t convHeight;
+		uint32_t ringCapacity;
+		uint32_t actionStride;
+		uint32_t slotStride;
+		std::atomic<uint32_t> bReady;
+
+		// Signal words are bumped on every push and used as futex words
+		alignas(64) std::atomic<uint32_t> observationSignal;
+		alignas(64) std::atomic<uint32_t> actionSignal;
+
+		// Ring indices, each written by exactly one side
+		alignas(64) std::atomic<uint32_t> observationHead;
+		alignas(64) std::atomic<uint32_t> observationTail;
+		alignas(64) std::atomic<uint32_t> actionHead;
+		alignas(64) std::atomic<uint32_t> actionTail;
+	};
+
+	struct alignas(64) Slot
+	{
+		// Odd while the simulator writes the slot
+		std::atomic<uint32_t> sequence;
+		uint32_t agentId;
+
+		// Bumped whenever the slot changes hands
+		uint32_t rollout;
+	};
+
+	// Observation ring entry, and the head of an action ring entry that is followed by the outputs
+	struct Entry
+	{
+		uint32_t slot;
+		uint32_t rollout;
+	};
+
+	// A slot and the rollout it belongs to, as known to the side that keeps it
+	struct SlotRef
+	{
+		uint32_t slot;
+		uint32_t rollout;
+	};
+
+	static size_t headerSize();
+	static size_t actionStride(uint32_t numOutputs);
+	static size_t slotStride(uint32_t numJoints, uint32_t convWidth, uint32_t convHeight);
+
+	bool map(const std::string& name, size_t size, bool bCreate);
+	void unmap();
+
+	uint8_t* observationRing() const;
+	uint8_t* actionRing() const;
+	Slot* slot(uint32_t index) const;
+	float* slotJoints(Slot* s) const;
+	uint8_t* slotConvPixels(Slot* s) const;
+
+	// Simulator side, only the simulator writes slot ownership
+	void setRollout(Slot* s, uint32_t agentId, uint32_t rollout);
+
+	// Entries are written in place: beginPush returns the next free entry or nullptr if the ring is full,
+	// front the oldest entry or nullptr if the ring is empty
+	uint8_t* beginPush(uint8_t* ring, size_t stride, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail);
+	void commitPush(std::atomic<uint32_t>& head);
+	const uint8_t* front(const uint8_t* ring, size_t stride, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail) const;
+	void pop(std::atomic<uint32_t>& tail);
+
+	void signal(std::atomic<uint32_t>& word, void* event);
+	bool wait(std::atomic<uint32_t>& word, std::atomic<uint32_t>& head, std::atomic<uint32_t>& tail, void* event, uint32_t timeoutMillis);
+
+	std::string _name;
+	Header* _header = nullptr;
+	uint8_t* _data = nullptr;
+	size_t _size = 0;
+	bool _bOwner = false;
+
+	// Process-local slot bookkeeping: the slots of running agents and, on the simulator side, the free ones
+	std::unordered_map<uint32_t, SlotRef> _agentSlots;
+	std::vector<uint32_t> _freeSlots;
+
+	// Platform handles
+	int _fd = -1;
+	void* _mapping = nullptr;
+	void* _observationEvent = nullptr;
+	void* _actionEvent = nullptr;
+};
@@ -0,0 +1,116 @@
+#include "SharedMemoryController.h"
+#include "OscProtocol.h"
+#include "ofxIniSettings.h"
+
+int SharedMemoryController::run()
+{
+	ofxIniSettings ini("settings.ini");
+	std::string host = ini.get("controller.host", "localhost");
+	_shmName = ini.get("controller.shm_name", "neatures");
+	_population = std::max(ini.get("evolution.max_parallel_sims", 1), 1);
+
+	_router.add(OSC_HELLO_IN, ROUTE_HELLO);
+	_router.add(OSC_INFO_IN, ROUTE_INFO);
+	_router.add(OSC_END, ROUTE_END);
+	_router.add(OSC_BYE_IN, ROUTE_BYE);
+
+	// Mirrors the simulator, which sends to controller.port and listens on controller.port_in
+	_receiver.setup(ini.get("controller.port", 1024));
+	_sender.setup(host, ini.get("controller.port_in", 1025));
+
+	ofLog() << "[Controller] Waiting for simulator on port " << ini.get("controller.port", 1024) << "...";
+
+	uint64_t reportStart = ofGetElapsedTimeMillis();
+	uint64_t reportActions = 0;
+
+	while (_bRunning) {
+		receive();
+
+		if (_channel.isOpen()) {
+			uint32_t agentId;
+			while (_channel.readObservation(agentId, &_joints[0], &_convPixels[0])) {
+				act(agentId);
+			}
+			_channel.waitForObservation(1);
+		}
+		else {
+			ofSleepMillis(1);
+		}
+
+		uint64_t now = ofGetElapsedTimeMillis();
+		if (now - reportStart >= 1000) {
+			if (_channel.isOpen()) {
+				ofLog() << "[Controller] actions/s: " << ofToString((_numActions - reportActions) * 1000.0 / (now - reportStart), 1) << " (generation " << _generation << ")";
+			}
+			reportStart = now;
+			reportActions = _numActions;
+		}
+	}
+	_channel.close();
+	_receiver.stop();
+	return 0;
+}
+
+void SharedMemoryController::receive()
+{
+	while (_receiver.hasWaitingMessages()) {
+		ofxOscMessage m;
+		_receiver.getNextMessage(&m);
+
+		int route = _router.match(m.getAddress(), _address);
+
+		if (route == ROUTE_HELLO && !_bConnected) {
+			ofxOscMessage hello;
+			hello.setAddress(OSC_HELLO);
+			_sender.sendMessage(hello);
+			_bConnected = true;
+		}
+		// The simulator has created its shared memory region before it says hello
+		if (route == ROUTE_INFO) {
+			if (!_channel.open(_shmName)) {
+				ofLogError() << "[Controller] Could not open shared memory channel '" << _shmName << "'";
+				_bRunning = false;
+				return;
+			}
+			_joints.resize(_channel.getNumJoints());
+			_outputs.resize(_channel.getNumOutputs());
+			_convPixels.resize(_channel.getConvWidth() * _channel.getConvHeight());
+			_ticks.resize(_channel.getNumSlots());
+
+			ofLog() << "[Controller] Attached to '" << _shmName << "': " << _channel.getNumJoints() << " joints, " << _channel.getNumSlots() << " slot(s)";
+			queueGeneration();
+		}
+		if (route == ROUTE_END) {
+			if (++_numFinished == _population) {
+				_generation++;
+				queueGeneration();
+			}
+		}
+		if (route == ROUTE_BYE) {
+			_bRunning = false;
+		}
+	}
+}
+
+void SharedMemoryController::queueGeneration()
+{
+	_numFinished = 0;
+	std::fill(_ticks.begin(), _ticks.end(), 0);
+
+	for (uint32_t i = 0; i < _population; i++) {
+		ofxOscMessage info;
+		info.setAddress(OSC_INFO + "/standin/" + ofToString(i) + '/' + ofToString(_generation) + '/' + ofToString(_duration));
+		_sender.sendMessage(info);
+	}
+}
+
+void SharedMemoryController::act(uint32_t agentId)
+{
+	// Travelling wave over the joints, the brush pressure output follows the first joint
+	float phase = _ticks[agentId % _ticks.size()]++ * 0.2f;
+	for (size_t i = 0; i < _outputs.size(); i++) {
+		_outputs[i] = std::sin(phase + i * 0.5f);
+	}
+	_channel.writeAction(agentId, &_outputs[0]);
+	_numActions++;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "OscRouter.h"
+#include "SharedMemoryChannel.h"
+#include "ofxOsc.h"
+
+// Stand-in for the evolution module that drives the simulator over the shared memory transport.
+// Runs as its own process (neatures --shm-controller), answers the OSC handshake, queues a population of
+// candidates every generation and replies to each observation with a sinusoidal effector vector.
+class SharedMemoryController
+{
+public:
+	int run();
+
+private:
+	enum Route { ROUTE_HELLO, ROUTE_INFO, ROUTE_END, ROUTE_BYE };
+
+	void receive();
+	void queueGeneration();
+	void act(uint32_t agentId);
+
+	ofxOscSender _sender;
+	ofxOscReceiver _receiver;
+	OscRouter _router;
+	OscAddress _address;
+	SharedMemoryChannel _channel;
+
+	std::string _shmName;
+	uint32_t _population = 1;
+	uint32_t _duration = 10;
+	uint32_t _generation = 0;
+	uint32_t _numFinished = 0;
+
+	std::vector<float> _joints;
+	std::vector<float> _outputs;
+	std::vector<uint8_t> _convPixels;
+	std::vector<uint32_t> _ticks;
+
+	uint64_t _numActions = 0;
+	bool _bConnected = false;
+	bool _bRunning = true;
+};
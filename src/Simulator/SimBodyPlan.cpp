@@ -0,0 +1,178 @@
+#include "Simulator/SimBodyPlan.h"
+#include "Utils/SimUtils.h"
+
+SimBodyPlan::SimBodyPlan(const DirectedGraph& graph)
+{
+	m_genome = std::make_unique<DirectedGraph>(graph);
+	m_genome->unfold();
+
+	m_numBrushes = m_genome->getNumBrushes();
+	m_segments.reserve(m_genome->getNumNodesUnfolded());
+
+	std::vector<int> recursionLimits(m_genome->getNodes().size());
+	for (int i = 0; i < recursionLimits.size(); i++) {
+		recursionLimits[i] = m_genome->getNodes()[i]->getRecursionLimit();
+	}
+	dfs(m_genome->getRootNode(), nullptr, -1, btVector3(1., 1., 1.), 1.0, 0.0, recursionLimits);
+}
+
+/// <summary>
+/// Traverses the genome graph using dfs and records a segment for every node in the unfolded phenome, in the same order
+/// as the rigid bodies of the creature. Positions are relative to the spawn position.
+/// </summary>
+/// <param name="graphNode">The current node to process.</param>
+/// <param name="incoming">The incoming graph connection. This must be nullptr if graphNode is the root node.</param>
+/// <param name="parentIndex">The segment index of the parent node. This must be -1 if graphNode is the root node.</param>
+/// <param name="parentDims">The dimensions of the parent object.</param>
+/// <param name="cascadingScale">The scaling factor of the current segment. This may be 1.0 if it graphNode is the root node.</param>
+/// <param name="attachment">The attachment coefficient of the current node [0..1]. This is always ci/nc where ci is the index of the outgoing connection and nc is the number of outgoing connections.</param>
+/// <param name="recursionLimits">A vector of recusrion limits for each graph node.</param>
+void SimBodyPlan::dfs(
+	GraphNode* graphNode, GraphConnection* incoming, int parentIndex, btVector3 parentDims,
+	btScalar cascadingScale, btScalar attachment, std::vector<int> recursionLimits)
+{
+	bool bIsRootNode = (incoming == nullptr);
+
+	if (!bIsRootNode) {
+		cascadingScale *= incoming->jointInfo.scalingFactor;
+	}
+	recursionLimits[graphNode->getGraphIndex()]--;
+
+	Segment segment;
+	segment.mass = 1.0;
+	segment.parent = parentIndex;
+	segment.bBrush = false;
+	segment.parentFrame.setIdentity();
+	segment.childFrame.setIdentity();
+	segment.lowerLimit = 0;
+	segment.upperLimit = 0;
+
+	btVector3 boxSize;
+
+	if (!bIsRootNode) {
+		btTransform parentWorldTrans = m_segments[parentIndex].transform;
+
+		btVector3 boxSizeParent = parentDims;
+		boxSize = graphNode->primitiveInfo.dimensions;
+		boxSize = btVector3(btMax(boxSize.x(), GraphNode::minSize), btMax(boxSize.y(), GraphNode::minSize), btMax(boxSize.z(), GraphNode::minSize));
+		boxSize = btVector3(btMin(boxSize.x(), GraphNode::maxSize), btMin(boxSize.y(), GraphNode::maxSize), btMin(boxSize.z(), GraphNode::maxSize));
+
+		btVector3 halfExtentsParent = boxSizeParent * 0.5;
+		btVector3 halfExtents = boxSize * 0.5;
+
+		// Calculate parent attachment point from plane
+		btVector3 planeForward = incoming->parent->primitiveInfo.parentAttachmentPlane.normalize();
+		btVector3 planeRight = SimUtils::getPerpOnNearestAxis(planeForward);
+
+		// Calculate local anchor points
+		btVector3 parentAnchorNormalLocal = planeRight.rotate(planeForward, SIMD_2_PI * attachment).normalize();
+		btVector3 childAnchorNormalLocal = incoming->jointInfo.childAnchorDir.normalize();
+
+		btVector3 parentSurfaceNormalLocal, childSurfaceNormalLocal;
+		btVector3 parentAnchorLocal = parentAnchorNormalLocal * abs(SimUtils::distToSurface(parentAnchorNormalLocal, halfExtentsParent, parentSurfaceNormalLocal));
+		btVector3 childAnchorLocal = childAnchorNormalLocal * abs(SimUtils::distToSurface(childAnchorNormalLocal, halfExtents, childSurfaceNormalLocal));
+
+		// Calculate world anchor point and the child origin in world
+		btVector3 anchorWorld = parentWorldTrans * parentAnchorLocal;
+		btVector3 parentAnchorNormalWorld = (parentWorldTrans.getBasis() * parentAnchorNormalLocal).normalized();
+
+		btVector3 childOriginWorld = anchorWorld + parentAnchorNormalWorld * childAnchorLocal.length();
+		btVector3 untransformedChildAnchorNormalWorld = (parentWorldTrans.getBasis() * childAnchorNormalLocal).normalized();
+
+		// Rotation to align parent and child normals
+		btQuaternion anchorAlignmentRot = SimUtils::glmToBullet(glm::rotation(
+			SimUtils::bulletToGlm(untransformedChildAnchorNormalWorld),
+			SimUtils::bulletToGlm(-parentAnchorNormalWorld)
+		));
+
+		// Build final child transform
+		btTransform childWorldTrans = btTransform(btMatrix3x3::getIdentity(), childOriginWorld) * btTransform(anchorAlignmentRot) * btTransform(parentWorldTrans.getBasis());
+
+		// Set up reference frames for axes
+		btVector3 jointAxis = incoming->jointInfo.axis.normalize();
+		btVector3 parentChildForward = (parentWorldTrans.getOrigin() - childWorldTrans.getOrigin());
+
+		if (parentChildForward.length() < SIMD_EPSILON) {
+			parentChildForward = btVector3(0, 1, 0);
+		}
+		parentChildForward.normalize();
+
+		btVector3 rotAxis = (jointAxis.cross(parentChildForward)).normalize();
+		btScalar theta = acos(jointAxis.dot(parentChildForward));
+		btQuaternion qq = btQuaternion(rotAxis, theta);
+
+		btTransform parentFrameInWorld;
+		parentFrameInWorld.setIdentity();
+		parentFrameInWorld.setOrigin(anchorWorld);
+		parentFrameInWorld.setRotation(childWorldTrans.inverse().getRotation() * qq);
+
+		btTransform childFrameInWorld;
+		childFrameInWorld.setIdentity();
+		childFrameInWorld.setOrigin(anchorWorld);
+		childFrameInWorld.setRotation(childWorldTrans.inverse().getRotation() * qq);
+
+		segment.transform = childWorldTrans;
+		segment.halfExtents = halfExtents;
+		segment.parentFrame = parentWorldTrans.inverse() * parentFrameInWorld;
+		segment.childFrame = childWorldTrans.inverse() * childFrameInWorld;
+		segment.lowerLimit = -SIMD_HALF_PI * btScalar(0.75);
+		segment.upperLimit = SIMD_HALF_PI * btScalar(0.75);
+
+		if (!m_bHasBrush && graphNode->primitiveInfo.brush != 0) {
+			segment.bBrush = true;
+			m_bHasBrush = true;
+		}
+	}
+	else { // ROOT BODY
+		btScalar startHeight = GraphNode::maxSize * 2.0;
+		segment.transform.setIdentity();
+		segment.transform.setOrigin(btVector3(0, startHeight, 0));
+
+		boxSize = graphNode->primitiveInfo.dimensions;
+		segment.halfExtents = boxSize * 0.5;
+	}
+
+	// Shapes and meshes are shared by all creatures built from this plan
+	segment.shape = std::make_shared<btBoxShape>(segment.halfExtents);
+	segment.shape->calculateLocalInertia(segment.mass, segment.localInertia);
+	segment.mesh = std::make_shared<ofMesh>(ofMesh::box(boxSize.x(), boxSize.y(), boxSize.z()));
+
+	int segmentIndex = m_segments.size();
+	m_segments.push_back(segment);
+
+	parentDims = boxSize;
+
+	int connectionIndex = 0;
+	for (GraphConnection* c : graphNode->getConnections()) {
+		if (recursionLimits[c->child->getGraphIndex()] > 0) {
+			btScalar attachment = connectionIndex/float(graphNode->getConnections().size());
+			dfs(c->child, c, segmentIndex, parentDims, cascadingScale, attachment, recursionLimits);
+		}
+		connectionIndex++;
+	}
+}
+
+const btAlignedObjectArray<SimBodyPlan::Segment>& SimBodyPlan::getSegments() const
+{
+	return m_segments;
+}
+
+const DirectedGraph& SimBodyPlan::getGenome() const
+{
+	return *m_genome;
+}
+
+uint32_t SimBodyPlan::getNumBodies() const
+{
+	return m_segments.size();
+}
+
+uint32_t SimBodyPlan::getNumJoints() const
+{
+	return m_segments.size() - 1;
+}
+
+uint32_t SimBodyPlan::getNumBrushes() const
+{
+	return m_numBrushes;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "btBulletDynamicsCommon.h"
+#include "ofMesh.h"
+#include "Genome/DirectedGraph.h"
+
+/// <summary>
+/// Immutable creature body plan derived from a genome. Segment transforms, hinge frames, collision shapes and
+/// meshes are computed once and shared by every creature instantiated from the plan.
+/// </summary>
+class SimBodyPlan
+{
+public:
+	struct Segment
+	{
+		// Initial transform relative to the spawn position
+		btTransform transform;
+		btVector3 halfExtents;
+		btVector3 localInertia;
+		btScalar mass;
+
+		// Index of the parent segment, -1 for the root
+		int parent;
+		bool bBrush;
+
+		// Hinge frames in parent and child body space
+		btTransform parentFrame;
+		btTransform childFrame;
+		btScalar lowerLimit;
+		btScalar upperLimit;
+
+		std::shared_ptr<btCollisionShape> shape;
+		std::shared_ptr<ofMesh> mesh;
+	};
+
+	SimBodyPlan(const DirectedGraph& graph);
+
+	const btAlignedObjectArray<Segment>& getSegments() const;
+	const DirectedGraph& getGenome() const;
+
+	uint32_t getNumBodies() const;
+	uint32_t getNumJoints() const;
+	uint32_t getNumBrushes() const;
+
+private:
+	void dfs(
+		GraphNode* graphNode, GraphConnection* incoming, int parentIndex, btVector3 parentDims,
+		btScalar cascadingScale, btScalar attachment, std::vector<int> recursionLimits
+	);
+
+	std::unique_ptr<DirectedGraph> m_genome;
+	btAlignedObjectArray<Segment> m_segments;
+
+	uint32_t m_numBrushes;
+	bool m_bHasBrush = false;
+};
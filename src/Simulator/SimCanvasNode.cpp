@@ -4,12 +4,16 @@
 #include "Utils/MeshUtils.h"
 #include "Utils/OFUtils.h"
 #include "ofMaterial.h"
+#include "ofAppRunner.h"
 
 // Maximum number of contactpoints registered and applied to canvas per frame.
 // This number should be synced with BRUSH_COORD_BUF_MAXSIZE in canvas.frag.
 #define BRUSH_COORD_BUF_MAXSIZE 16
 
-SimCanvasNode::SimCanvasNode(btVector3 position, float size, float viewSize, float boundsMargin, int xRes, int yRes, int xConvRes, int yConvRes, btDynamicsWorld* ownerWorld) :
+// Canvas regions are painted and colorized in tiles of this size (pixels)
+#define CANVAS_TILE_SIZE 32
+
+SimCanvasNode::SimCanvasNode(btVector3 position, float size, float viewSize, float boundsMargin, int xRes, int yRes, int xConvRes, int yConvRes, btDynamicsWorld* ownerWorld, Backend backend) :
     SimNodeBase(CanvasTag, ownerWorld), _canvasSize(size), _patchSize(viewSize), _margin(boundsMargin), _areaSize(size + boundsMargin)
 {
     _color = ofColor::white;
@@ -18,22 +22,65 @@ SimCanvasNode::SimCanvasNode(btVector3 position, float size, float viewSize, flo
     _canvasRes = glm::ivec2(xRes, yRes);
     _canvasConvRes = glm::vec2(xConvRes, yConvRes);
 
-    _drawQuad = MeshUtils::rectMesh(0, 0, _canvasRes.x, _canvasRes.y, true);
     _drawQuadConv = MeshUtils::rectMesh(0, 0, _canvasConvRes.x, _canvasConvRes.y, true);
 
     initPlane(position, _canvasSize);
-    
-    // Single-channel canvas 'height map'
-    for (int i = 0; i < 2; i++) {
-        _fbo[i].allocate(_canvasRes.x, _canvasRes.y, GL_R8);
-        _fbo[i].getTexture().setTextureWrap(GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER);
-
-        _fbo[i].getTexture().bind();
-        ofFloatColor color(0.0f, 0.0f, 0.0f, 0.0f);
-        glTexParameterfv(GL_TEXTURE_RECTANGLE, GL_TEXTURE_BORDER_COLOR, &color.r);
-        _fbo[i].getTexture().unbind();
+
+    // The first colorize pass covers the whole canvas
+    _numTiles = (_canvasRes + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE;
+    _strokeTiles.assign(_numTiles.x * _numTiles.y, 0);
+    _colorTiles.assign(_numTiles.x * _numTiles.y, 1);
+    _tileMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+
+    _backend = backend;
+    _bGraphics = ofGetGLRenderer() != nullptr;
+
+    // The cpu backend only needs render buffers to display its memory buffers
+    if (_backend == GPU || _bGraphics) {
+        initRenderBuffers();
+    }
+    if (_backend == CPU) {
+        _rasterizer.allocate(_canvasRes.x, _canvasRes.y);
+        _colorPixels.allocate(_canvasRes.x, _canvasRes.y, OF_PIXELS_RGBA);
+        _colorPixels.set(0);
+        _bTrackCoverage = true;
+    }
+
+    _brushCoordQueue.resize(BRUSH_COORD_BUF_MAXSIZE);
+    for (int i = 0; i < BRUSH_COORD_BUF_MAXSIZE; i++) {
+        _brushCoordQueue[i].reset();
+    }
+    _convPixelBuffer.allocate(_canvasConvRes.x, _canvasConvRes.y, 1);
+    _convPixelBuffer.set(0);
+
+    if (_backend == GPU) {
+        _brushCoordBuffer.allocate();
+        _brushCoordBuffer.setData(BrushCoord::size()*BRUSH_COORD_BUF_MAXSIZE, NULL, GL_DYNAMIC_DRAW);
+
+        // Neural input
+        for (int i = 0; i < 2; i++) {
+            _pixelWriteBuffers[i].allocate(_canvasRes.x * _canvasRes.y, GL_DYNAMIC_READ);
+        }
     }
 
+    iPbo = 0;
+    _pboPtr = &_pixelWriteBuffers[iPbo];
+
+    getRigidBody()->setCollisionFlags(btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT);
+}
+
+void SimCanvasNode::initRenderBuffers()
+{
+    // Single-channel canvas 'height map'. Brush strokes are max-blended into it directly,
+    // the pressure shader never samples the canvas so there is no need to ping-pong.
+    _fbo.allocate(_canvasRes.x, _canvasRes.y, GL_R8);
+    _fbo.getTexture().setTextureWrap(GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER);
+
+    _fbo.getTexture().bind();
+    ofFloatColor color(0.0f, 0.0f, 0.0f, 0.0f);
+    glTexParameterfv(GL_TEXTURE_RECTANGLE, GL_TEXTURE_BORDER_COLOR, &color.r);
+    _fbo.getTexture().unbind();
+
     // Reduced resolution neural input buffer
     ofFboSettings fboSettings;
     fboSettings.width = _canvasConvRes.x;
@@ -51,107 +98,189 @@ SimCanvasNode::SimCanvasNode(btVector3 position, float size, float viewSize, flo
     _colorFbo.begin();
     ofClear(_color.r, _color.b, _color.g, 0.0f);
     _colorFbo.end();
+}
 
-    _brushCoordQueue.resize(BRUSH_COORD_BUF_MAXSIZE);
+void SimCanvasNode::initPlane(btVector3 position, float size)
+{
+    _mesh = std::make_shared<ofMesh>(MeshUtils::gridMesh(2, 2, size*2, true));
+
+    btCollisionShape* shape = new btStaticPlaneShape(btVector3(0, 1, 0), 0);
+    createBody(position, shape, 0, this);
+}
+
+void SimCanvasNode::update()
+{
+    if (_backend == CPU) {
+        updateCpu();
+    }
+    else {
+        updateGpu();
+    }
+
+    if (_brushQueueSize > 0)
+    {
+        // copy the last brush coord to local vision cache
+        if (_cachedBrushCoord.coord != _brushCoordQueue[_brushQueueSize - 1].coord) {
+            _cachedBrushCoord = _brushCoordQueue[_brushQueueSize - 1];
+        }
+
+        btScalar z, y, x;
+        _cachedLocalVisionRotation.getEulerZYX(z, y, x);
+
+        float theta = -y;
+        _localVisionRotationMatrix = glm::vec4(
+            cos(theta), -sin(theta),
+            sin(theta), cos(theta)
+        );
+    }
+
+    // This is just for visualization so completely optional and can be skipped in headless mode
+    if (_bColorizeOnUpdate) {
+        updateColorMap();
+    }
+
+    // invalidate values
     for (int i = 0; i < BRUSH_COORD_BUF_MAXSIZE; i++) {
         _brushCoordQueue[i].reset();
     }
-    _brushCoordBuffer.allocate();
-    _brushCoordBuffer.setData(BrushCoord::size()*BRUSH_COORD_BUF_MAXSIZE, NULL, GL_DYNAMIC_DRAW);
+    std::fill(_strokeTiles.begin(), _strokeTiles.end(), 0);
+    _brushQueueSize = 0;
+}
 
-    // Neural input
-    for (int i = 0; i < 2; i++) {
-        _pixelWriteBuffers[i].allocate(_canvasRes.x * _canvasRes.y, GL_DYNAMIC_READ);
+void SimCanvasNode::reset(btVector3 position)
+{
+    // Move the plane and bounds if the canvas is reused at another location
+    btVector3 offset = position - getPosition();
+    if (!offset.fuzzyZero()) {
+        bool bInWorld = getRigidBody()->isInWorld();
+        removeFromWorld();
+
+        setPosition(position);
+        if (_bBounds) {
+            for (int i = 0; i < 4; i++) {
+                _bounds[i]->setPosition(_bounds[i]->getPosition() + offset);
+            }
+        }
+        if (bInWorld) {
+            addToWorld();
+        }
     }
-    _convPixelBuffer.allocate(_canvasConvRes.x, _canvasConvRes.y, 1);
 
-    iPbo = 0;
-    _pboPtr = &_pixelWriteBuffers[iPbo];
+    // Clear paint in place, the next colorize pass covers the whole canvas again
+    if (_backend == CPU) {
+        _rasterizer.clear();
+    }
+    else {
+        _fbo.clearColorBuffer(ofFloatColor(0, 0, 0, 0));
+        if (_bTrackCoverage) {
+            _coverageRasterizer.clear();
+        }
+    }
+    clearConvPixelBuffer();
 
-    getRigidBody()->setCollisionFlags(btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT);
+    _paintSum = 0;
+    _numPaintedStrokes = 0;
+
+    std::fill(_strokeTiles.begin(), _strokeTiles.end(), 0);
+    std::fill(_colorTiles.begin(), _colorTiles.end(), 1);
+
+    for (int i = 0; i < BRUSH_COORD_BUF_MAXSIZE; i++) {
+        _brushCoordQueue[i].reset();
+    }
+    _brushQueueSize = 0;
+
+    _cachedBrushCoord.reset();
+    _cachedLocalVisionRotation = btQuaternion::getIdentity();
+    _localVisionRotationMatrix = glm::vec4();
 }
 
-void SimCanvasNode::initPlane(btVector3 position, float size)
+void SimCanvasNode::updateCpu()
 {
-    _mesh = std::make_shared<ofMesh>(MeshUtils::gridMesh(2, 2, size*2, true));
-
-    btCollisionShape* shape = new btStaticPlaneShape(btVector3(0, 1, 0), 0);
-    createBody(position, shape, 0, this);
+    for (unsigned int i = 0; i < _brushQueueSize; i++) {
+        _paintSum += _rasterizer.stamp(_brushCoordQueue[i].coord, _brushCoordQueue[i].pressure);
+    }
 }
 
-void SimCanvasNode::update()
+void SimCanvasNode::updateGpu()
 {
     if (_updateShader && _brushQueueSize > 0)
     {
+        // cpu copy of the strokes, the paint map itself is never read back during a rollout
+        if (_bTrackCoverage) {
+            for (unsigned int i = 0; i < _brushQueueSize; i++) {
+                _paintSum += _coverageRasterizer.stamp(_brushCoordQueue[i].coord, _brushCoordQueue[i].pressure);
+            }
+        }
+
         // bind coord buffers
         _brushCoordBuffer.bindBase(GL_SHADER_STORAGE_BUFFER, 0);
         _brushCoordBuffer.updateData(0, _brushCoordQueue);
 
-        // update shader
-        iFbo = OFUtils::swap(iFbo);
+        // update shader, only on the tiles the brush coords can reach
+        buildTileMesh(_strokeTiles);
 
         glEnable(GL_BLEND);
         glBlendEquation(GL_MAX);
         glBlendFunc(GL_ONE, GL_ONE);
-        _fbo[iFbo].begin();
-
-        _fbo[OFUtils::swap(iFbo)].draw(0, 0);
+        _fbo.begin();
 
         _updateShader->begin();
         _updateShader->setUniform1f("use_brush_pressure", _bVariableBrushPressure);
         _updateShader->setUniform1i("brush_coords_bufsize", _brushQueueSize);
 
-        _drawQuad.draw();
+        _tileMesh.draw();
         _updateShader->end();
-        _fbo[iFbo].end();
+        _fbo.end();
 
         glBlendEquation(GL_FUNC_ADD);
         glDisable(GL_BLEND);
 
         _brushCoordBuffer.unbindBase(GL_SHADER_STORAGE_BUFFER, 0);
-
-        // copy the last brush coord to local vision cache
-        if (_cachedBrushCoord.coord != _brushCoordQueue[_brushQueueSize - 1].coord) {
-            _cachedBrushCoord = _brushCoordQueue[_brushQueueSize - 1];
-        }
-
-        btScalar z, y, x;
-        _cachedLocalVisionRotation.getEulerZYX(z, y, x);
-
-        float theta = -y;
-        _localVisionRotationMatrix = glm::vec4(
-            cos(theta), -sin(theta),
-            sin(theta), cos(theta)
-        );
     }
+}
 
-    // This is just for visualization so completely optional and can be skipped in headless mode
-    if (_colorizeShader) {
+void SimCanvasNode::updateColorMap()
+{
+    if (_backend == CPU) {
+        forEachDirtySpan(_colorTiles, [this](const ofRectangle& region) {
+            _rasterizer.colorize(_colorPixels, _brushColor, _color, region);
+            if (_bGraphics) {
+                uploadRegion(_colorFbo.getTexture(), _colorPixels, region);
+            }
+        });
+    }
+    else if (_colorizeShader) {
+        buildTileMesh(_colorTiles);
+        if (_tileMesh.getNumIndices() == 0) {
+            return;
+        }
         _colorFbo.begin();
 
         _colorizeShader->begin();
-        _colorizeShader->setUniformTexture("tex", _fbo[iFbo].getTexture(), 0);
+        _colorizeShader->setUniformTexture("tex", _fbo.getTexture(), 0);
         _colorizeShader->setUniform4f("brush_color", _brushColor);
         _colorizeShader->setUniform4f("canvas_color", _color);
-        _drawQuad.draw();
+        _tileMesh.draw();
         _colorizeShader->end();
 
         _colorFbo.end();
     }
-
-    // invalidate values
-    for (int i = 0; i < BRUSH_COORD_BUF_MAXSIZE; i++) {
-        _brushCoordQueue[i].reset();
-    }
-    _brushQueueSize = 0;
 }
 
 void SimCanvasNode::updateConvPixelBuffer()
 {
+    if (_backend == CPU) {
+        _rasterizer.samplePatch(_convPixelBuffer, _cachedBrushCoord.coord, _patchSize, _localVisionRotationMatrix);
+        if (_bGraphics) {
+            _convFbo.getTexture().loadData(_convPixelBuffer);
+        }
+        return;
+    }
+
     // Sample local patch from full-size canvas fbo
     _convFbo.begin();
     _subTextureShader->begin();
-    _subTextureShader->setUniformTexture("tex", _fbo[iFbo].getTexture(), 0);
+    _subTextureShader->setUniformTexture("tex", _fbo.getTexture(), 0);
     _subTextureShader->setUniform2f("patchLocation", _cachedBrushCoord.coord);
     _subTextureShader->setUniform1f("patchSize", _patchSize);
     _subTextureShader->setUniform4f("patchRotationMatrix", _localVisionRotationMatrix);
@@ -175,6 +304,12 @@ void SimCanvasNode::updateConvPixelBuffer()
 
 void SimCanvasNode::clearConvPixelBuffer()
 {
+    if (_backend == CPU) {
+        _convPixelBuffer.set(0);
+        if (!_bGraphics) {
+            return;
+        }
+    }
     _convFbo.clearColorBuffer(ofFloatColor(0,0,0,0));
 }
 
@@ -217,6 +352,12 @@ void SimCanvasNode::addBrushStroke(btVector3 location, float pressure, bool acti
         _brushCoordQueue[_brushQueueSize].coord = px;
         _brushCoordQueue[_brushQueueSize].pressure = glm::clamp(pressure, 0.0f, 1.0f);
         _brushCoordQueue[_brushQueueSize].active = active;
+
+        ofRectangle bounds = SimCanvasRasterizer::stampBounds(px, _brushCoordQueue[_brushQueueSize].pressure, _canvasRes.x, _canvasRes.y);
+        if (!bounds.isEmpty()) {
+            markTiles(bounds);
+            _numPaintedStrokes++;
+        }
         _brushQueueSize++;
     }
 }
@@ -226,6 +367,83 @@ void SimCanvasNode::setLocalVisionRotation(btQuaternion rotationMatrix)
     _cachedLocalVisionRotation = rotationMatrix;
 }
 
+void SimCanvasNode::markTiles(const ofRectangle& region)
+{
+    if (region.isEmpty()) {
+        return;
+    }
+    int x0 = int(region.getMinX()) / CANVAS_TILE_SIZE;
+    int y0 = int(region.getMinY()) / CANVAS_TILE_SIZE;
+    int x1 = (int(region.getMaxX()) - 1) / CANVAS_TILE_SIZE;
+    int y1 = (int(region.getMaxY()) - 1) / CANVAS_TILE_SIZE;
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            _strokeTiles[y * _numTiles.x + x] = 1;
+            _colorTiles[y * _numTiles.x + x] = 1;
+        }
+    }
+}
+
+void SimCanvasNode::forEachDirtySpan(std::vector<uint8_t>& tiles, std::function<void(const ofRectangle&)> func)
+{
+    // Merge horizontally adjacent dirty tiles into spans and reset them
+    for (int y = 0; y < _numTiles.y; y++) {
+        int x = 0;
+        while (x < _numTiles.x) {
+            if (!tiles[y * _numTiles.x + x]) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < _numTiles.x && tiles[y * _numTiles.x + x]) {
+                tiles[y * _numTiles.x + x] = 0;
+                x++;
+            }
+            int px = start * CANVAS_TILE_SIZE;
+            int py = y * CANVAS_TILE_SIZE;
+            int pw = std::min(x * CANVAS_TILE_SIZE, _canvasRes.x) - px;
+            int ph = std::min(py + CANVAS_TILE_SIZE, _canvasRes.y) - py;
+            func(ofRectangle(px, py, pw, ph));
+        }
+    }
+}
+
+void SimCanvasNode::buildTileMesh(std::vector<uint8_t>& tiles)
+{
+    // Same vertex and texcoord layout as a full canvas MeshUtils::rectMesh, restricted to the dirty spans
+    _tileMesh.clear();
+    forEachDirtySpan(tiles, [this](const ofRectangle& r) {
+        ofIndexType i = _tileMesh.getNumVertices();
+        glm::vec2 invRes = 1.0f / glm::vec2(_canvasRes);
+
+        _tileMesh.addVertex(glm::vec3(r.getMinX(), r.getMinY(), 0));
+        _tileMesh.addVertex(glm::vec3(r.getMaxX(), r.getMinY(), 0));
+        _tileMesh.addVertex(glm::vec3(r.getMinX(), r.getMaxY(), 0));
+        _tileMesh.addVertex(glm::vec3(r.getMaxX(), r.getMaxY(), 0));
+        _tileMesh.addTexCoord(glm::vec2(r.getMinX(), r.getMinY()) * invRes);
+        _tileMesh.addTexCoord(glm::vec2(r.getMaxX(), r.getMinY()) * invRes);
+        _tileMesh.addTexCoord(glm::vec2(r.getMinX(), r.getMaxY()) * invRes);
+        _tileMesh.addTexCoord(glm::vec2(r.getMaxX(), r.getMaxY()) * invRes);
+        _tileMesh.addTriangle(i, i + 1, i + 2);
+        _tileMesh.addTriangle(i + 1, i + 3, i + 2);
+    });
+}
+
+void SimCanvasNode::uploadRegion(ofTexture& texture, const ofPixels& pixels, const ofRectangle& region)
+{
+    const ofTextureData& texData = texture.getTextureData();
+    const uint8_t* src = pixels.getData() + (size_t(region.y) * pixels.getWidth() + size_t(region.x)) * pixels.getNumChannels();
+
+    glBindTexture(texData.textureTarget, texData.textureID);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pixels.getWidth());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(texData.textureTarget, 0, region.x, region.y, region.width, region.height, ofGetGLFormat(pixels), GL_UNSIGNED_BYTE, src);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(texData.textureTarget, 0);
+}
+
 void SimCanvasNode::swapPbo()
 {
     iPbo = (iPbo + 1) % 2;
@@ -237,6 +455,11 @@ glm::ivec2 SimCanvasNode::getCanvasResolution()
     return _canvasRes;
 }
 
+SimCanvasNode::Backend SimCanvasNode::getBackend() const
+{
+    return _backend;
+}
+
 const ofFbo* SimCanvasNode::getViewMap() const
 {
     return &_convFbo;
@@ -244,7 +467,7 @@ const ofFbo* SimCanvasNode::getViewMap() const
 
 const ofFbo* SimCanvasNode::getPaintMap() const
 {
-    return &_fbo[iFbo];
+    return &_fbo;
 }
 
 const ofFbo* SimCanvasNode::getPaintMapRGBA() const
@@ -257,6 +480,16 @@ const ofPixels& SimCanvasNode::getConvPixelBuffer()
     return _convPixelBuffer;
 }
 
+const ofPixels& SimCanvasNode::getPaintMapPixels() const
+{
+    return _rasterizer.getPixels();
+}
+
+const ofPixels& SimCanvasNode::getPaintMapRGBAPixels() const
+{
+    return _colorPixels;
+}
+
 void SimCanvasNode::setCanvasUpdateShader(std::shared_ptr<ofShader> shader) {
     _updateShader = shader; 
 }
@@ -269,6 +502,37 @@ void SimCanvasNode::setSubTextureShader(std::shared_ptr<ofShader> shader) {
     _subTextureShader = shader;
 }
 
+void SimCanvasNode::setColorizeOnUpdate(bool enable) {
+    _bColorizeOnUpdate = enable;
+}
+
+void SimCanvasNode::setCoverageTracking(bool enable)
+{
+    if (_backend == CPU) {
+        return;
+    }
+    if (enable && !_bTrackCoverage) {
+        _coverageRasterizer.allocate(_canvasRes.x, _canvasRes.y);
+        _paintSum = 0;
+    }
+    _bTrackCoverage = enable;
+}
+
+bool SimCanvasNode::isCoverageTracked() const
+{
+    return _bTrackCoverage;
+}
+
+double SimCanvasNode::getCoverage() const
+{
+    return _paintSum / (255.0 * _canvasRes.x * _canvasRes.y);
+}
+
+uint32_t SimCanvasNode::getNumPaintedStrokes() const
+{
+    return _numPaintedStrokes;
+}
+
 void SimCanvasNode::spawnBounds(bool bDebugRender)
 {
     if (_bBounds) {
@@ -1,5 +1,6 @@
 #pragma once
 #include "SimNode.h"
+#include "SimCanvasRasterizer.h"
 #include "ofBufferObject.h"
 #include "ofFbo.h"
 #include "ofPixels.h"
@@ -7,10 +8,15 @@
 class SimCanvasNode : public SimNodeBase
 {
 public:
-	SimCanvasNode(btVector3 position, float size, float viewSize, float boundsMargin, int xRes, int yRes, int xNeuralInput, int yNeuralInput, btDynamicsWorld* ownerWorld);
+	// GPU paints with shaders into ping-pong fbos, CPU paints into plain memory and needs no GL context
+	enum Backend { GPU, CPU };
+
+	SimCanvasNode(btVector3 position, float size, float viewSize, float boundsMargin, int xRes, int yRes, int xNeuralInput, int yNeuralInput, btDynamicsWorld* ownerWorld, Backend backend = GPU);
 	~SimCanvasNode();
 
 	void update();
+	void reset(btVector3 position);
+	void updateColorMap();
 	void updateConvPixelBuffer();
 	void clearConvPixelBuffer();
 
@@ -26,9 +32,22 @@ public:
 	void setCanvasUpdateShader(std::shared_ptr<ofShader> shader);
 	void setCanvasColorizeShader(std::shared_ptr<ofShader> shader);
 	void setSubTextureShader(std::shared_ptr<ofShader> shader);
+	void setColorizeOnUpdate(bool enable);
 	void spawnBounds(bool bDebugRender = true);
 
+	// The cpu backend tracks coverage as a side effect of painting, the gpu backend mirrors its strokes into a memory
+	// buffer for this. Enable before the rollout starts painting
+	void setCoverageTracking(bool enable);
+	bool isCoverageTracked() const;
+
+	// Mean paint intensity [0..1] since the last reset, kept up to date as strokes land
+	double getCoverage() const;
+
+	// Brush strokes that landed on the canvas since the last reset, zero means the paint map is blank
+	uint32_t getNumPaintedStrokes() const;
+
 	glm::ivec2 getCanvasResolution();
+	Backend getBackend() const;
 
 	// Full-resolution single-channel paint map
 	const ofFbo* getPaintMap() const;
@@ -42,6 +61,12 @@ public:
 	// Downsampled single-channel paint map buffer
 	const ofPixels& getConvPixelBuffer();
 
+	// Full-resolution single-channel paint map in memory (CPU backend only)
+	const ofPixels& getPaintMapPixels() const;
+
+	// Full-resolution RGBA paint map in memory, valid after updateColorMap (CPU backend only)
+	const ofPixels& getPaintMapRGBAPixels() const;
+
 private:
 	struct BrushCoord {
 		glm::vec2 coord;
@@ -59,8 +84,18 @@ private:
 	};
 
 	void initPlane(btVector3 position, float size);
+	void initRenderBuffers();
 	void swapPbo();
 
+	// dirty tiles
+	void markTiles(const ofRectangle& region);
+	void forEachDirtySpan(std::vector<uint8_t>& tiles, std::function<void(const ofRectangle&)> func);
+	void buildTileMesh(std::vector<uint8_t>& tiles);
+	void uploadRegion(ofTexture& texture, const ofPixels& pixels, const ofRectangle& region);
+
+	void updateGpu();
+	void updateCpu();
+
 	// canvas
 	glm::ivec2 _canvasRes;
 	glm::ivec2 _canvasConvRes;
@@ -70,9 +105,14 @@ private:
 	float _patchSize;
 	float _margin;
 
-	ofMesh _drawQuad;
 	ofMesh _drawQuadConv;
 
+	// Only tiles touched by brush strokes are painted and colorized
+	glm::ivec2 _numTiles;
+	std::vector<uint8_t> _strokeTiles; // touched by the queued brush coords
+	std::vector<uint8_t> _colorTiles; // painted since the last colorize pass
+	ofMesh _tileMesh;
+
 	// brush coords
 	ofBufferObject _brushCoordBuffer;
 	std::vector<BrushCoord> _brushCoordQueue;
@@ -86,10 +126,22 @@ private:
 	ofFbo _convFbo;
 	ofFbo _convLocalFbo;
 	ofFbo _colorFbo;
-	ofFbo _fbo[2];
-	int iFbo = 0;
+	ofFbo _fbo;
 
 	bool _bVariableBrushPressure = true;
+	bool _bColorizeOnUpdate = true;
+
+	// cpu backend
+	Backend _backend;
+	SimCanvasRasterizer _rasterizer;
+	ofPixels _colorPixels;
+	bool _bGraphics;
+
+	// coverage, gpu strokes are stamped into _coverageRasterizer to count their paint
+	SimCanvasRasterizer _coverageRasterizer;
+	uint64_t _paintSum = 0;
+	uint32_t _numPaintedStrokes = 0;
+	bool _bTrackCoverage = false;
 
 	ofPixels _convPixelBuffer;
 	ofBufferObject _pixelWriteBuffers[2];
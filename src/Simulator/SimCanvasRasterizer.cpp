@@ -0,0 +1,205 @@
+#include "SimCanvasRasterizer.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CANVAS_RASTERIZER_SSE2
+#endif
+
+namespace
+{
+	inline uint8_t toUnorm8(float v)
+	{
+		return uint8_t(v * 255.0f + 0.5f);
+	}
+
+	// Stamps pixels [x0, x1) of a single row. dy2 is the squared vertical distance to the brush center.
+	// Same as smoothstep(press + fade, press - fade, dist) in canvas_pressure.frag, invRange is 1/(edge1 - edge0).
+	// Returns the paint added to the row.
+	uint32_t stampRowScalar(uint8_t* row, int x0, int x1, float invWidth, float cx, float dy2, float edge0, float invRange)
+	{
+		uint32_t added = 0;
+		for (int x = x0; x < x1; x++) {
+			float dx = (x + 0.5f) * invWidth - cx;
+			float t = glm::clamp((std::sqrt(dx * dx + dy2) - edge0) * invRange, 0.0f, 1.0f);
+			uint8_t v = toUnorm8(t * t * (3.0f - 2.0f * t));
+			if (v > row[x]) {
+				added += v - row[x];
+				row[x] = v;
+			}
+		}
+		return added;
+	}
+
+#ifdef CANVAS_RASTERIZER_SSE2
+	inline __m128 stampQuad(int x, __m128 lane, __m128 invWidth, __m128 cx, __m128 dy2, __m128 edge0, __m128 invRange)
+	{
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		__m128 px = _mm_add_ps(_mm_add_ps(_mm_set1_ps(float(x)), lane), half);
+		__m128 dx = _mm_sub_ps(_mm_mul_ps(px, invWidth), cx);
+		__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), dy2));
+		__m128 t = _mm_mul_ps(_mm_sub_ps(dist, edge0), invRange);
+		t = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+		// t * t * (3 - 2t), scaled to 8-bit and rounded
+		__m128 s = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_add_ps(t, t)));
+		return _mm_add_ps(_mm_mul_ps(s, _mm_set1_ps(255.0f)), half);
+	}
+
+	uint32_t stampRow(uint8_t* row, int x0, int x1, float invWidth, float cx, float dy2, float edge0, float invRange)
+	{
+		const __m128 vInvWidth = _mm_set1_ps(invWidth);
+		const __m128 vCx = _mm_set1_ps(cx);
+		const __m128 vDy2 = _mm_set1_ps(dy2);
+		const __m128 vEdge0 = _mm_set1_ps(edge0);
+		const __m128 vInvRange = _mm_set1_ps(invRange);
+		const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+		// 16 pixels per iteration: four float quads packed down to a single byte vector
+		// The added paint is the sum of absolute differences between the blended and the old pixels
+		__m128i added = _mm_setzero_si128();
+		int x = x0;
+		for (; x + 16 <= x1; x += 16) {
+			__m128i a = _mm_cvttps_epi32(stampQuad(x, lane, vInvWidth, vCx, vDy2, vEdge0, vInvRange));
+			__m128i b = _mm_cvttps_epi32(stampQuad(x + 4, lane, vInvWidth, vCx, vDy2, vEdge0, vInvRange));
+			__m128i c = _mm_cvttps_epi32(stampQuad(x + 8, lane, vInvWidth, vCx, vDy2, vEdge0, vInvRange));
+			__m128i d = _mm_cvttps_epi32(stampQuad(x + 12, lane, vInvWidth, vCx, vDy2, vEdge0, vInvRange));
+			__m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+
+			__m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			__m128i blended = _mm_max_epu8(dst, v);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), blended);
+			added = _mm_add_epi64(added, _mm_sad_epu8(blended, dst));
+		}
+		uint32_t sum = uint32_t(_mm_cvtsi128_si32(added)) + uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(added, 8)));
+		return sum + stampRowScalar(row, x, x1, invWidth, cx, dy2, edge0, invRange);
+	}
+#else
+	uint32_t stampRow(uint8_t* row, int x0, int x1, float invWidth, float cx, float dy2, float edge0, float invRange)
+	{
+		return stampRowScalar(row, x0, x1, invWidth, cx, dy2, edge0, invRange);
+	}
+#endif
+}
+
+void SimCanvasRasterizer::allocate(int width, int height)
+{
+	_width = width;
+	_height = height;
+	_pixels.allocate(width, height, OF_PIXELS_GRAY);
+	clear();
+}
+
+void SimCanvasRasterizer::clear()
+{
+	_pixels.set(0);
+}
+
+float SimCanvasRasterizer::brushRadius(float pressure)
+{
+	float y = 1.0f - std::pow(std::sin(PI * ((pressure + 1.0f) / 2.0f)), 2.0f);
+	return glm::clamp(y, 0.0f, 1.0f) * thickness;
+}
+
+ofRectangle SimCanvasRasterizer::stampBounds(glm::vec2 coord, float pressure, int width, int height)
+{
+	// Only the pixels whose centers lie within the outer edge can receive paint
+	const float edge0 = brushRadius(pressure) + fade;
+	int x0 = std::max(int(std::floor((coord.x - edge0) * width - 0.5f)), 0);
+	int x1 = std::min(int(std::ceil((coord.x + edge0) * width + 0.5f)), width);
+	int y0 = std::max(int(std::floor((coord.y - edge0) * height - 0.5f)), 0);
+	int y1 = std::min(int(std::ceil((coord.y + edge0) * height + 0.5f)), height);
+
+	if (x1 <= x0 || y1 <= y0) {
+		return ofRectangle();
+	}
+	return ofRectangle(x0, y0, x1 - x0, y1 - y0);
+}
+
+uint32_t SimCanvasRasterizer::stamp(glm::vec2 coord, float pressure)
+{
+	const float press = brushRadius(pressure);
+	const float edge0 = press + fade;
+	const float edge1 = press - fade;
+	const float invRange = 1.0f / (edge1 - edge0);
+
+	const float invWidth = 1.0f / _width;
+	const float invHeight = 1.0f / _height;
+
+	ofRectangle bounds = stampBounds(coord, pressure, _width, _height);
+	int x0 = bounds.getMinX();
+	int x1 = bounds.getMaxX();
+	int y0 = bounds.getMinY();
+	int y1 = bounds.getMaxY();
+
+	uint32_t added = 0;
+	uint8_t* data = _pixels.getData();
+	for (int y = y0; y < y1; y++) {
+		float dy = (y + 0.5f) * invHeight - coord.y;
+		added += stampRow(data + size_t(y) * _width, x0, x1, invWidth, coord.x, dy * dy, edge0, invRange);
+	}
+	return added;
+}
+
+void SimCanvasRasterizer::samplePatch(ofPixels& dst, glm::vec2 location, float patchSize, glm::vec4 rotation) const
+{
+	const uint8_t* src = _pixels.getData();
+	const int w = dst.getWidth();
+	const int h = dst.getHeight();
+	uint8_t* out = dst.getData();
+
+	auto texel = [&](int x, int y) -> float {
+		return (x < 0 || y < 0 || x >= _width || y >= _height) ? 0.0f : src[size_t(y) * _width + x];
+	};
+
+	for (int r = 0; r < h; r++) {
+		for (int c = 0; c < w; c++) {
+			// st * mat2(rotation), same as subtexture.frag
+			glm::vec2 st = glm::vec2((c + 0.5f) / w, (r + 0.5f) / h) - 0.5f;
+			glm::vec2 rotated(st.x * rotation.x + st.y * rotation.y, st.x * rotation.z + st.y * rotation.w);
+			glm::vec2 uv = rotated * patchSize + location;
+
+			// GL_LINEAR with a black border
+			float tx = uv.x * _width - 0.5f;
+			float ty = uv.y * _height - 0.5f;
+			int ix = int(std::floor(tx));
+			int iy = int(std::floor(ty));
+			float fx = tx - ix;
+			float fy = ty - iy;
+
+			float top = glm::mix(texel(ix, iy), texel(ix + 1, iy), fx);
+			float bottom = glm::mix(texel(ix, iy + 1), texel(ix + 1, iy + 1), fx);
+			out[r * w + c] = uint8_t(glm::mix(top, bottom, fy) + 0.5f);
+		}
+	}
+}
+
+void SimCanvasRasterizer::colorize(ofPixels& dst, ofColor brushColor, ofColor canvasColor, const ofRectangle& region) const
+{
+	// Lookup table instead of a per-pixel mix, the paint map only has 256 levels
+	ofColor lut[256];
+	for (int i = 0; i < 256; i++) {
+		lut[i] = canvasColor.getLerped(brushColor, i / 255.0f);
+		lut[i].a = 255;
+	}
+
+	for (int y = region.getMinY(); y < region.getMaxY(); y++) {
+		const uint8_t* src = _pixels.getData() + size_t(y) * _width;
+		uint8_t* out = dst.getData() + size_t(y) * _width * 4;
+
+		for (int x = region.getMinX(); x < region.getMaxX(); x++) {
+			const ofColor& col = lut[src[x]];
+			out[x * 4 + 0] = col.r;
+			out[x * 4 + 1] = col.g;
+			out[x * 4 + 2] = col.b;
+			out[x * 4 + 3] = col.a;
+		}
+	}
+}
+
+const ofPixels& SimCanvasRasterizer::getPixels() const
+{
+	return _pixels;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "ofPixels.h"
+#include "ofColor.h"
+#include "ofRectangle.h"
+#include "ofVectorMath.h"
+
+// CPU counterpart of the canvas_pressure, subtexture and lum2col shaders.
+// Paints into plain 8-bit memory so the canvas can run without a GL context.
+class SimCanvasRasterizer
+{
+public:
+	void allocate(int width, int height);
+	void clear();
+
+	// Stamps a single brush coordinate (normalized texture coordinates) using GL_MAX blending.
+	// Returns the paint that was added, the sum of the increase of every pixel
+	uint32_t stamp(glm::vec2 coord, float pressure);
+
+	// Samples a rotated, scaled patch around location into dst (bilinear, zero outside the canvas)
+	void samplePatch(ofPixels& dst, glm::vec2 location, float patchSize, glm::vec4 rotation) const;
+
+	// Maps paint intensity to an RGBA color map within region (pixels)
+	void colorize(ofPixels& dst, ofColor brushColor, ofColor canvasColor, const ofRectangle& region) const;
+
+	const ofPixels& getPixels() const;
+
+	// Brush radius in normalized texture coordinates for a given pressure, identical to canvas_pressure.frag
+	static float brushRadius(float pressure);
+
+	// Pixel region that a stamp can write to on a canvas of the given resolution
+	static ofRectangle stampBounds(glm::vec2 coord, float pressure, int width, int height);
+
+	// Keep these in sync with canvas_pressure.frag
+	static constexpr float thickness = 1.0f / 64.0f;
+	static constexpr float fade = 1.0f / 512.0f;
+
+private:
+	ofPixels _pixels;
+	int _width = 0;
+	int _height = 0;
+};
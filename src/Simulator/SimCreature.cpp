@@ -8,14 +8,15 @@
 #define World2Loc SimUtils::b3RefFrameHelper::getTransformWorldToLocal
 #define Loc2World SimUtils::b3RefFrameHelper::getTransformLocalToWorld
 
-btRigidBody* localCreateRigidBody(btScalar mass, const btTransform& startTransform, btCollisionShape* shape);
+btRigidBody* localCreateRigidBody(btScalar mass, const btTransform& startTransform, btCollisionShape* shape, const btVector3& localInertia);
 
 SimCreature::SimCreature(btVector3 position, const std::shared_ptr<DirectedGraph>& graph, btDynamicsWorld* ownerWorld)
-	: m_ownerWorld(ownerWorld)
+	: SimCreature(position, std::make_shared<SimBodyPlan>(*graph), ownerWorld) {}
+
+SimCreature::SimCreature(btVector3 position, const std::shared_ptr<const SimBodyPlan>& bodyPlan, btDynamicsWorld* ownerWorld)
+	: m_ownerWorld(ownerWorld), m_bodyPlan(bodyPlan)
 {
 	m_spawnPosition = position;
-	m_bodyGenome = new DirectedGraph(*graph);
-	m_bodyGenome->unfold();
 
 	m_motorStrength = 0.025f * m_ownerWorld->getSolverInfo().m_numIterations;
 	m_targetFrequency = 3;
@@ -23,18 +24,20 @@ SimCreature::SimCreature(btVector3 position, const std::shared_ptr<DirectedGraph
 
 	m_bodyColor = ofFloatColor::fromHsb(ofRandom(1.0f), 0.7f, 1.0f, 1.0f);
 
-	buildPhenome(m_bodyGenome);
+	buildPhenome();
 }
 
 /// <summary>
-/// Initializes a creature phenome from a given genome.
+/// Instantiates the creature phenome from its body plan. Shapes and meshes are shared with the plan, so this only
+/// creates the rigid bodies and hinges.
 /// </summary>
-/// <param name="graph">The data structure for the creature genome.</param>
-void SimCreature::buildPhenome(DirectedGraph* graph)
+void SimCreature::buildPhenome()
 {
-	m_numBodies = graph->getNumNodesUnfolded();
-	m_numBrushes = graph->getNumBrushes();
-	m_numJoints = m_numBodies - 1;
+	const btAlignedObjectArray<SimBodyPlan::Segment>& segments = m_bodyPlan->getSegments();
+
+	m_numBodies = m_bodyPlan->getNumBodies();
+	m_numBrushes = m_bodyPlan->getNumBrushes();
+	m_numJoints = m_bodyPlan->getNumJoints();
 	m_numOutputs = m_numJoints + m_numBrushes;
 
 	m_nodes.resize(m_numBodies);
@@ -44,185 +47,43 @@ void SimCreature::buildPhenome(DirectedGraph* graph)
 	m_touchSensors.resize(m_numBodies);
 	m_outputs.resize(m_numOutputs);
 
-	std::vector<int> recursionLimits(graph->getNodes().size());
-	for (int i = 0; i < recursionLimits.size(); i++) {
-		recursionLimits[i] = graph->getNodes()[i]->getRecursionLimit();
-	}
+	for (int i = 0; i < m_numBodies; i++) {
+		const SimBodyPlan::Segment& segment = segments[i];
 
-	int segmentIndex = 0;
-	dfs(graph->getRootNode(), nullptr, nullptr, graph, btVector3(1., 1., 1.), 1.0, 0.0, recursionLimits, segmentIndex);
-}
+		btTransform trans = segment.transform;
+		trans.setOrigin(trans.getOrigin() + m_spawnPosition);
 
-/// <summary>
-/// Recursive function that traverses the genome graph using dfs to fully initialize the creature phenome.
-/// </summary>
-/// <param name="graphNode">The current node to process.</param>
-/// <param name="incoming">The incoming graph connection. This must be nullptr if graphNode is the root node.</param>
-/// <param name="parentSimNode">The phenome SimNode object associated with the parent node. This must be nullptr if it graphNode is the root node.</param>
-/// <param name="graph">The data structure for the creature genome.</param>
-/// <param name="parentDims">The dimensions of the parent object.</param>
-/// <param name="cascadingScale">The scaling factor of the current SimNode. This may be 1.0 if it graphNode is the root node.</param>
-/// <param name="attachment">The attachment coefficient of the current node [0..1]. Used to determined where a new node should be pointed on a parent attachment plane. This is always ci/nc where ci is the index of the outgoing connection and nc is the number of outgoing connections.</param>
-/// <param name="recursionLimits">A vector of recusrion limits for each graph node.</param>
-/// <param name="segmentIndex">The segment index of the current SimNode. This must be 0 if it graphNode is the root node.</param>
-void SimCreature::dfs(
-	GraphNode* graphNode, GraphConnection* incoming, SimNode* parentSimNode, DirectedGraph* graph, 
-	btVector3 parentDims, btScalar cascadingScale, btScalar attachment, std::vector<int> recursionLimits, int& segmentIndex)
-{
-	bool bIsRootNode = (incoming == nullptr);
-
-	if (!bIsRootNode) {
-		cascadingScale *= incoming->jointInfo.scalingFactor;
-	}
-	recursionLimits[graphNode->getGraphIndex()]--;
-	
-	SimNode* simNodePtr = new SimNode(BodyTag, m_bodyColor, m_ownerWorld);
-	simNodePtr->setCreatureOwner(this);
-
-	if (!bIsRootNode) {
-		segmentIndex++;
-
-		btTransform parentWorldTrans = parentSimNode->getRigidBody()->getWorldTransform();
-
-		btVector3 boxSizeParent = parentDims;
-		btVector3 boxSize = graphNode->primitiveInfo.dimensions; // *cascadingScale;
-		boxSize = btVector3(btMax(boxSize.x(), GraphNode::minSize), btMax(boxSize.y(), GraphNode::minSize), btMax(boxSize.z(), GraphNode::minSize));
-		boxSize = btVector3(btMin(boxSize.x(), GraphNode::maxSize), btMin(boxSize.y(), GraphNode::maxSize), btMin(boxSize.z(), GraphNode::maxSize));
-		
-		btVector3 halfExtentsParent = boxSizeParent * 0.5;
-		btVector3 halfExtents = boxSize * 0.5;
-
-		// Calculate parent attachment point from plane
-		btVector3 planeForward = incoming->parent->primitiveInfo.parentAttachmentPlane.normalize();
-		btVector3 planeRight = SimUtils::getPerpOnNearestAxis(planeForward);
-		//ofLog() << "VERIFY planeForward . planeRight = " << planeForward.dot(planeRight) << std::endl;
-
-		// Calculate local anchor points
-		btVector3 parentAnchorNormalLocal = planeRight.rotate(planeForward, SIMD_2_PI * attachment).normalize();
-		btVector3 childAnchorNormalLocal = incoming->jointInfo.childAnchorDir.normalize();
-
-		// Calculate local anchor points
-		btVector3 parentSurfaceNormalLocal, childSurfaceNormalLocal;
-		btVector3 parentAnchorLocal = parentAnchorNormalLocal * abs(SimUtils::distToSurface(parentAnchorNormalLocal, halfExtentsParent, parentSurfaceNormalLocal));
-		btVector3 childAnchorLocal = childAnchorNormalLocal * abs(SimUtils::distToSurface(childAnchorNormalLocal, halfExtents, childSurfaceNormalLocal));
-
-		// Calculate world anchor point and the child origin in world
-		btVector3 anchorWorld = parentWorldTrans * parentAnchorLocal;
-		btVector3 parentAnchorNormalWorld = (parentWorldTrans.getBasis() * parentAnchorNormalLocal).normalized();
-
-		btVector3 childOriginWorld = anchorWorld + parentAnchorNormalWorld * childAnchorLocal.length();
-		btVector3 untransformedChildAnchorNormalWorld = (parentWorldTrans.getBasis() * childAnchorNormalLocal).normalized();
-
-		// Rotation to align parent and child normals
-		btQuaternion anchorAlignmentRot = SimUtils::glmToBullet(glm::rotation(
-			SimUtils::bulletToGlm(untransformedChildAnchorNormalWorld),
-			SimUtils::bulletToGlm(-parentAnchorNormalWorld)
-		));
-		btVector3 childAnchorWorld = childOriginWorld + btTransform(anchorAlignmentRot) * (parentWorldTrans.getBasis() * childAnchorLocal);
-		btVector3 childAnchorNormalWorld = (childAnchorWorld - childOriginWorld).normalized();
-
-		btScalar alignmentDot = btDot(parentAnchorNormalWorld, childAnchorNormalWorld);
-		btScalar parentChildDistance = parentAnchorLocal.length() + childAnchorLocal.length();
-
-		/// Verification
-		//ofLog() << "VERIFY alignment: " << std::endl << "parentAnchor . childAnchor = " << alignmentDot << std::endl; // should be parallel but point in opposite directions (dot: -1.0)
-		//ofLog() << "VERIFY anchors: " << std::endl << SimUtils::bulletToGlm(anchorWorld) << " | " << SimUtils::bulletToGlm(childAnchorWorld) << std::endl;
-		//ofLog() << "VERIFY distance: " << std::endl << parentChildDistance << " | " << (childOriginWorld - parentWorldTrans.getOrigin()).length() << std::endl;
-
-		// Build final child transform
-		btTransform childWorldTrans = btTransform(btMatrix3x3::getIdentity(), childOriginWorld) * btTransform(anchorAlignmentRot) * btTransform(parentWorldTrans.getBasis());
-
-		btCollisionShape* shape = new btBoxShape(halfExtents);
-		btRigidBody* body = localCreateRigidBody(1.0f, childWorldTrans, shape);
+		SimNode* simNodePtr = new SimNode(BodyTag, m_bodyColor, m_ownerWorld);
+		simNodePtr->setCreatureOwner(this);
+
+		btRigidBody* body = localCreateRigidBody(segment.mass, trans, segment.shape.get(), segment.localInertia);
 		body->setUserPointer(simNodePtr);
 
-		// Set up reference frames for axes
-		btVector3 jointAxis = incoming->jointInfo.axis.normalize();
-		btVector3 parentChildForward = (parentWorldTrans.getOrigin() - childWorldTrans.getOrigin());
+		simNodePtr->setRigidBody(body, false);
+		simNodePtr->setMesh(segment.mesh);
 
-		if (parentChildForward.length() < SIMD_EPSILON) {
-			parentChildForward = UP;
-		}
-		parentChildForward.normalize();
-
-		//if (abs(btDot(jointAxis, parentChildForward)) > btScalar(1.) - SIMD_EPSILON) {
-		//	jointAxis = SimUtils::getPerpOnNearestAxis(jointAxis);
-		//}
-		btVector3 rotAxis = (jointAxis.cross(parentChildForward)).normalize();
-		btScalar theta = acos(jointAxis.dot(parentChildForward));
-		btQuaternion qq = btQuaternion(rotAxis, theta);
-
-		btTransform frameInWorld;
-		frameInWorld.setIdentity();
-		frameInWorld.setOrigin(anchorWorld);
-
-		btTransform parentFrameInWorld;
-		parentFrameInWorld.setIdentity();
-		parentFrameInWorld.setOrigin(anchorWorld);
-		parentFrameInWorld.setRotation(childWorldTrans.inverse().getRotation() * qq);
-
-		btTransform childFrameInWorld;
-		childFrameInWorld.setIdentity();
-		childFrameInWorld.setOrigin(anchorWorld);
-		childFrameInWorld.setRotation(childWorldTrans.inverse().getRotation() * qq);
-
-		btHingeConstraint* joint = new btHingeConstraint(
-			*parentSimNode->getRigidBody(), *body,
-			parentWorldTrans.inverse() * parentFrameInWorld, 
-			childWorldTrans.inverse() * childFrameInWorld
-		);
-		joint->setLimit(-SIMD_HALF_PI * btScalar(0.75), SIMD_HALF_PI * btScalar(0.75));
-		joint->setDbgDrawSize(0.25f);
-		joint->setEnabled(true);
-
-		simNodePtr->setRigidBody(body);
-		simNodePtr->setMesh(std::make_shared<ofMesh>(ofMesh::box(boxSize.x(), boxSize.y(), boxSize.z())));
-		if (!m_bHasBrush && graphNode->primitiveInfo.brush != 0) {
+		if (segment.bBrush) {
 			simNodePtr->setTag(BrushTag | BodyTag);
 			simNodePtr->setInkColor(INK);
 			m_brushNodes.push_back(simNodePtr);
 			m_bHasBrush = true;
 		}
 
-		m_nodes[segmentIndex] = simNodePtr;
-		m_bodies[segmentIndex] = body;
-		m_bodyTouchSensorIndexMap.insert(btHashPtr(body), segmentIndex);
-		m_joints.push_back(joint);
-
-		parentDims = boxSize;
-	}
-	else { // ROOT BODY
-		btScalar startHeight = GraphNode::maxSize * 2.0;
-		btTransform trans;
-		trans.setIdentity();
-		trans.setOrigin(m_spawnPosition + btVector3(0, startHeight, 0));
-
-		btVector3 boxSize = graphNode->primitiveInfo.dimensions;
-		btVector3 halfExtents = boxSize * 0.5;
-
-		btCollisionShape* shape = new btBoxShape(halfExtents);
-		btRigidBody* body = localCreateRigidBody(1.0, trans, shape);
-		body->setUserPointer(simNodePtr);
-
-		simNodePtr->setRigidBody(body);
-		simNodePtr->setMesh(std::make_shared<ofMesh>(ofMesh::box(boxSize.x(), boxSize.y(), boxSize.z())));
-
-		m_rootNode = simNodePtr;
-		m_nodes[segmentIndex] = simNodePtr;
-		m_bodies[segmentIndex] = body;
-		m_bodyTouchSensorIndexMap.insert(btHashPtr(body), segmentIndex);
-
-		parentDims = boxSize;
-	}
-
-	int connectionIndex = 0;
-	for (GraphConnection* c : graphNode->getConnections()) {
-		if (recursionLimits[c->child->getGraphIndex()] > 0) {
-			btScalar attachment = connectionIndex/float(graphNode->getConnections().size());
-			dfs(c->child, c, simNodePtr, graph, parentDims, cascadingScale, attachment, recursionLimits, segmentIndex);
+		if (segment.parent >= 0) {
+			btHingeConstraint* joint = new btHingeConstraint(
+				*m_bodies[segment.parent], *body, segment.parentFrame, segment.childFrame
+			);
+			joint->setLimit(segment.lowerLimit, segment.upperLimit);
+			joint->setDbgDrawSize(0.25f);
+			joint->setEnabled(true);
+			m_joints.push_back(joint);
 		}
-		connectionIndex++;
+
+		m_nodes[i] = simNodePtr;
+		m_bodies[i] = body;
+		m_bodyTouchSensorIndexMap.insert(btHashPtr(body), i);
 	}
+	m_rootNode = m_nodes[0];
 }
 
 bool SimCreature::isAwaitingEffectorUpdate()
@@ -288,14 +149,8 @@ void SimCreature::update()
 	clearTouchSensors();
 }
 
-btRigidBody* localCreateRigidBody(btScalar mass, const btTransform& startTransform, btCollisionShape* shape)
+btRigidBody* localCreateRigidBody(btScalar mass, const btTransform& startTransform, btCollisionShape* shape, const btVector3& localInertia)
 {
-	bool isDynamic = (mass != 0.f);
-
-	btVector3 localInertia(0, 0, 0);
-	if (isDynamic)
-		shape->calculateLocalInertia(mass, localInertia);
-
 	btDefaultMotionState* motionState = new btDefaultMotionState(startTransform);
 	btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, motionState, shape, localInertia);
 	btRigidBody* body = new btRigidBody(rbInfo);
@@ -348,7 +203,7 @@ void SimCreature::drawImmediate()
 }
 const DirectedGraph& SimCreature::getBodyGenome()
 {
-	return *m_bodyGenome;
+	return m_bodyPlan->getGenome();
 }
 
 uint32_t SimCreature::getID()
@@ -435,6 +290,49 @@ void SimCreature::removeFromWorld()
 	}
 }
 
+/// <summary>
+/// Puts the creature back in its initial pose so it can be reused for another rollout without rebuilding the phenome.
+/// </summary>
+/// <param name="position">The new spawn position.</param>
+void SimCreature::reset(btVector3 position)
+{
+	removeFromWorld();
+
+	const btVector3 zero(0, 0, 0);
+	const btAlignedObjectArray<SimBodyPlan::Segment>& segments = m_bodyPlan->getSegments();
+	for (int i = 0; i < m_numBodies; i++) {
+		btTransform trans = segments[i].transform;
+		trans.setOrigin(trans.getOrigin() + position);
+
+		btRigidBody* body = m_bodies[i];
+		body->setWorldTransform(trans);
+		body->setInterpolationWorldTransform(trans);
+		body->getMotionState()->setWorldTransform(trans);
+		body->setLinearVelocity(zero);
+		body->setAngularVelocity(zero);
+		body->setInterpolationLinearVelocity(zero);
+		body->setInterpolationAngularVelocity(zero);
+		body->clearForces();
+		body->forceActivationState(ACTIVE_TAG);
+		body->setDeactivationTime(0.8);
+	}
+	for (btTypedConstraint* joint : m_joints) {
+		static_cast<btHingeConstraint*>(joint)->enableAngularMotor(false, 0, 0);
+	}
+	for (SimNode* brush : m_brushNodes) {
+		brush->setBrushPressure(0.0f);
+	}
+
+	m_spawnPosition = position;
+	m_targetAccumulator = 0;
+	m_timeStep = 0;
+	m_bAwaitingEffectorUpdate = false;
+	std::fill(m_outputs.begin(), m_outputs.end(), 0.0f);
+	clearTouchSensors();
+
+	addToWorld();
+}
+
 btVector3 SimCreature::getSpawnPosition() const
 {
 	return m_spawnPosition;
@@ -524,5 +422,4 @@ SimCreature::~SimCreature()
 	for (auto &node : m_nodes) {
 		delete node;
 	}
-	if (m_bodyGenome) delete m_bodyGenome;
 }
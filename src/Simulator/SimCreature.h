@@ -2,6 +2,7 @@
 #include "btBulletCollisionCommon.h"
 #include "Simulator/SimNode.h"
 #include "Simulator/SimCanvasNode.h"
+#include "Simulator/SimBodyPlan.h"
 #include "ofGraphics.h"
 #include "ofMaterial.h"
 #include "Graphics/MaterialBase.h"
@@ -14,6 +15,9 @@ public:
 	// Initialization from a graph genome
 	SimCreature(btVector3 position, const std::shared_ptr<DirectedGraph>& graph, btDynamicsWorld* ownerWorld);
 
+	// Initialization from a prebuilt body plan that is shared between creatures
+	SimCreature(btVector3 position, const std::shared_ptr<const SimBodyPlan>& bodyPlan, btDynamicsWorld* ownerWorld);
+
 	~SimCreature();
 
 	bool isAwaitingEffectorUpdate();
@@ -51,6 +55,9 @@ public:
 	void addToWorld();
 	void removeFromWorld();
 
+	// Moves all bodies back to their initial pose at position and clears the simulation state
+	void reset(btVector3 position);
+
 	btVector3 getSpawnPosition() const;
 	btVector3 getCenterOfMassPosition() const;
 	btQuaternion getRootNodeRotation() const;
@@ -67,21 +74,16 @@ public:
 	uint32_t m_targetFrequency;
 
 private:
-	void buildPhenome(DirectedGraph* graph);
-	void dfs(
-		GraphNode* graphNode, GraphConnection* incoming, SimNode* parentSimNode, DirectedGraph* graph, 
-		btVector3 parentDims, btScalar cascadingScale, btScalar attachment, std::vector<int> recursionLimits, int& segmentIndex
-	);
+	void buildPhenome();
 
 	bool bInitialized = false;
 
 	btDynamicsWorld* m_ownerWorld;
-	DirectedGraph* m_bodyGenome = NULL;
+	std::shared_ptr<const SimBodyPlan> m_bodyPlan;
 	uint32_t m_id = 0;
 
 	// standard rigid bodies and shapes for creature
 	std::vector<btRigidBody*> m_bodies;
-	std::vector<btCollisionShape*> m_shapes;
 	std::vector<SimNode*> m_nodes;
 	std::vector<SimNode*> m_brushNodes;
 	std::vector<btTypedConstraint*> m_joints;
@@ -1,5 +1,6 @@
 #include "SimInstance.h"
 #include "SimDefines.h"
+#include "ofUtils.h"
 
 SimInstance::SimInstance(int id, int generation, SimWorld* world, SimCreature* crtr, SimCanvasNode* canv, btScalar duration) :
 	_instanceId(id), _generation(generation), _world(world), _creature(crtr), _canvas(canv), _duration(duration), _elapsed(0) 
@@ -7,19 +8,53 @@ SimInstance::SimInstance(int id, int generation, SimWorld* world, SimCreature* c
 	_world->setSimInstance(this);
 }
 
-void SimInstance::updateTimeStep(double timeStep)
+void SimInstance::reset(int id, int generation, btScalar duration, btVector3 position)
 {
+	_instanceId = id;
+	_generation = generation;
+	_duration = duration;
+	_elapsed = 0;
+
+	_bIsAwaitingOutputUpdate = false;
+	_bIsTerminated = false;
+
+	_awaitStartMicros = 0;
+	_lastAwaitMicros = 0;
+	_totalAwaitMicros = 0;
+	_numAwaits = 0;
+	_bIsFinished = false;
+
+	_plateauStart = 0;
+	_plateauCoverage = 0.0;
+	_bIsStagnant = false;
+
+	_world->reset();
+	_creature->reset(position);
+	_canvas->reset(position);
+}
+
+bool SimInstance::updateTimeStep(double timeStep)
+{
+	bool bStepped = false;
 	if (!_bIsFinished) {
 		// prevent updates if an effector vector is required
 		if (!_creature->isAwaitingEffectorUpdate()) {
 			_creature->updateTimeStep(timeStep);
 			_world->getBtWorld()->stepSimulation(timeStep, 1, FIXED_TIMESTEP);
 			_elapsed += timeStep;
+			bStepped = true;
+
+			// start of a wait for the controller
+			if (_creature->isAwaitingEffectorUpdate()) {
+				_bIsAwaitingOutputUpdate = true;
+				_awaitStartMicros = ofGetElapsedTimeMicros();
+			}
 		}
 		if (_elapsed >= _duration) {
 			_bIsFinished = true;
 		}
 	}
+	return bStepped;
 }
 
 void SimInstance::updateCreature()
@@ -27,11 +62,57 @@ void SimInstance::updateCreature()
 	_creature->update();
 }
 
+void SimInstance::updateEffectors(const std::vector<float>& outputs)
+{
+	_creature->updateOutputs(outputs);
+	_creature->update();
+
+	if (_bIsAwaitingOutputUpdate) {
+		_lastAwaitMicros = ofGetElapsedTimeMicros() - _awaitStartMicros;
+		_totalAwaitMicros += _lastAwaitMicros;
+		_numAwaits++;
+		_bIsAwaitingOutputUpdate = false;
+	}
+}
+
 void SimInstance::updateCanvas() 
 {
 	_canvas->setLocalVisionRotation(_creature->getRootNodeRotation());
 	_canvas->update();
 	_canvas->updateConvPixelBuffer();
+
+	updateStagnation();
+}
+
+void SimInstance::setEarlyTermination(btScalar idleTime, btScalar plateauTime, double plateauGain)
+{
+	_idleTime = idleTime;
+	_plateauTime = plateauTime;
+	_plateauGain = plateauGain;
+}
+
+void SimInstance::updateStagnation()
+{
+	if (_bIsFinished) {
+		return;
+	}
+	if (_idleTime > 0 && _elapsed >= _idleTime && _canvas->getNumPaintedStrokes() == 0) {
+		_bIsStagnant = true;
+	}
+	else if (_plateauTime > 0 && _canvas->isCoverageTracked()) {
+		// The window restarts whenever coverage has grown enough since it started
+		double coverage = _canvas->getCoverage();
+		if (coverage - _plateauCoverage >= _plateauGain) {
+			_plateauCoverage = coverage;
+			_plateauStart = _elapsed;
+		}
+		else if (_elapsed - _plateauStart >= _plateauTime) {
+			_bIsStagnant = true;
+		}
+	}
+	if (_bIsStagnant) {
+		_bIsFinished = true;
+	}
 }
 
 void SimInstance::terminate()
@@ -49,6 +130,11 @@ bool SimInstance::isFinished()
 	return _bIsFinished;
 }
 
+bool SimInstance::isStagnant()
+{
+	return _bIsStagnant;
+}
+
 bool SimInstance::isEffectorUpdateRequired()
 {
 	return _creature->isAwaitingEffectorUpdate();
@@ -74,6 +160,21 @@ btScalar SimInstance::getDuration()
 	return _duration;
 }
 
+uint64_t SimInstance::getLastAwaitMicros()
+{
+	return _lastAwaitMicros;
+}
+
+uint64_t SimInstance::getTotalAwaitMicros()
+{
+	return _totalAwaitMicros;
+}
+
+uint32_t SimInstance::getNumAwaits()
+{
+	return _numAwaits;
+}
+
 SimWorld* SimInstance::getWorld()
 {
 	return _world;
@@ -8,25 +8,43 @@ public:
     SimInstance(int id, int generation, SimWorld* world, SimCreature* crtr, SimCanvasNode* canv, btScalar duration);
     ~SimInstance();
 
-    void updateTimeStep(double timeStep);
+    // Prepares the instance for another rollout, reusing its world, creature and canvas
+    void reset(int id, int generation, btScalar duration, btVector3 position);
+
+    // Returns true if the physics world was stepped
+    bool updateTimeStep(double timeStep);
     void updateCanvas();
     void updateCreature();
+    // Applies an effector vector from the controller and ends the current wait
+    void updateEffectors(const std::vector<float>& outputs);
     void terminate();
 
+    // Finishes rollouts early that have not painted after idleTime seconds, or whose canvas coverage grew less than
+    // plateauGain during the last plateauTime seconds (0 disables a check). Plateaus need a coverage tracking canvas
+    void setEarlyTermination(btScalar idleTime, btScalar plateauTime, double plateauGain);
+
     bool isEffectorUpdateRequired();
     bool isTerminated();
     bool isFinished();
+    bool isStagnant();
 
     int getID();
     int getGeneration();
     btScalar getElapsedTime();
     btScalar getDuration();
 
+    // Time spent in isEffectorUpdateRequired() waiting for the controller
+    uint64_t getLastAwaitMicros();
+    uint64_t getTotalAwaitMicros();
+    uint32_t getNumAwaits();
+
     SimWorld* getWorld();
     SimCreature* getCreature();
     SimCanvasNode* getCanvas();
 
 private:
+    void updateStagnation();
+
     SimWorld* _world;
     SimCreature* _creature;
     SimCanvasNode* _canvas;
@@ -35,7 +53,20 @@ private:
     int _generation;
     btScalar _elapsed, _duration;
 
+    uint64_t _awaitStartMicros = 0;
+    uint64_t _lastAwaitMicros = 0;
+    uint64_t _totalAwaitMicros = 0;
+    uint32_t _numAwaits = 0;
+
+    // early termination
+    btScalar _idleTime = 0;
+    btScalar _plateauTime = 0;
+    double _plateauGain = 0.0;
+    btScalar _plateauStart = 0;
+    double _plateauCoverage = 0.0;
+
     bool _bIsAwaitingOutputUpdate = false;
     bool _bIsTerminated = false;
     bool _bIsFinished = false;
+    bool _bIsStagnant = false;
 };
@@ -5,7 +5,7 @@
 SimNodeBase::SimNodeBase(int tag, btDynamicsWorld* owner) : _tag(tag), _ownerWorld(owner) {}
 SimNodeBase::SimNodeBase(int tag, ofColor color, btDynamicsWorld* owner) : _tag(tag), _color(color), _ownerWorld(owner) {}
 
-void SimNodeBase::setRigidBody(btRigidBody* body)
+void SimNodeBase::setRigidBody(btRigidBody* body, bool bOwnsShape)
 {
     removeFromWorld();
     dealloc();
@@ -13,6 +13,7 @@ void SimNodeBase::setRigidBody(btRigidBody* body)
     _body = body;
     _body->setUserIndex(_tag);
     _shape = _body->getCollisionShape();
+    _bOwnsShape = bOwnsShape;
 }
 
 void SimNodeBase::createBody(btVector3 position, btCollisionShape* shape, float mass, void* userPointer)
@@ -135,7 +136,7 @@ void SimNodeBase::dealloc() {
         delete _body->getMotionState();
         delete _body;
     }
-    if (_shape) {
+    if (_shape && _bOwnsShape) {
         delete _shape;
     }
 }
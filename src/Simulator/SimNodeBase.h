@@ -18,7 +18,8 @@ public:
 
 	btDynamicsWorld* _ownerWorld;
 
-	void setRigidBody(btRigidBody* body);
+	// Shapes that are shared between bodies (bOwnsShape = false) are not deleted with the node
+	void setRigidBody(btRigidBody* body, bool bOwnsShape = true);
 	btRigidBody* getRigidBody();
 	btCollisionShape* getShape();
 
@@ -59,6 +60,7 @@ protected:
 
 	btCollisionShape* _shape = NULL;
 	btRigidBody* _body = NULL;
+	bool _bOwnsShape = true;
 	uint32_t _tag;
 
 	ofColor _color;
@@ -111,6 +111,12 @@ void handleCollisions(btDynamicsWorld* worldPtr, bool bCanvasSensors)
     }
 }
 
+void SimWorld::reset()
+{
+    _world->getConstraintSolver()->reset();
+    _world->clearForces();
+}
+
 SimInstance* SimWorld::getSimInstance()
 {
     return _owner;
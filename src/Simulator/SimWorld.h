@@ -14,6 +14,9 @@ public:
     SimWorld();
     ~SimWorld();
 
+    // Clears solver state so the world can be reused for another rollout
+    void reset();
+
     SimInstance* getSimInstance();
     void setSimInstance(SimInstance* instance);
 
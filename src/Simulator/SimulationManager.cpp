@@ -19,11 +19,25 @@ void SimulationManager::init(SimSettings settings)
     _simInstanceLimit = settings.maxParallelSims;
     _simInstanceGridSize = sqrt(_simInstanceLimit);
 
+    // headless -- no draw calls, so the colorize pass only runs for artifacts that are saved
+    bHeadless = settings.headless;
+
     _simulationInstances.reserve(_simInstanceLimit);
+    _simInstancePool.reserve(_simInstanceLimit);
     _simulationInstanceCallbackQueue.reserve(_simInstanceLimit);
 
-    // rendering -- load shaders and texture data from disk
-    loadShaders();
+    // no point in spawning more workers than there are instances to step
+    uint32_t numSimThreads = settings.numSimThreads ? settings.numSimThreads : std::thread::hardware_concurrency();
+    _jobSystem.setup(std::max(std::min(numSimThreads, _simInstanceLimit), 1u));
+    _instanceStepped.reserve(_simInstanceLimit);
+    ofLog() << "Simulation threads: " << _jobSystem.getNumThreads();
+
+    // rendering -- a windowless node with a cpu canvas has no GL context to load shaders and textures into
+    bGraphics = ofGetGLRenderer() != nullptr;
+    if (bGraphics) {
+        loadShaders();
+        loadMaterials();
+    }
 
     // camera
     cam.setNearClip(0.01f);
@@ -31,47 +45,6 @@ void SimulationManager::init(SimSettings settings)
     cam.setPosition(8.0f, 8.0f, 4.0f);
     cam.lookAt(glm::vec3(0));
 
-    // Load terrain material
-    _terrainMaterial = std::make_shared<PBRMaterial>(ofFloatColor::white, 0.0625f, 0.125f, 1.0f);
-    std::shared_ptr<PBRMaterial> _terrainMtlAccessPtr = std::dynamic_pointer_cast<PBRMaterial>(_terrainMaterial);
-    _terrainMtlAccessPtr->setup(
-        "materials/wood/WoodFloor024_1K_Color.jpg",
-        "materials/wood/WoodFloor024_1K_Normal.jpg",
-        "",
-        "materials/wood/WoodFloor024_1K_Roughness.jpg",
-        "materials/wood/WoodFloor024_1K_AmbientOcclusion.jpg"
-    );
-    _terrainMtlAccessPtr->setNormalMapMult(0.5f);
-    _terrainMtlAccessPtr->setMetallic(0.0f);
-
-    // Load canvas material
-    _canvasMaterial = std::make_shared<PBRMaterial>(ofFloatColor::white, 0.125f, 0.75f, 1.0f);
-    std::shared_ptr<PBRMaterial> _canvasMtlAccessPtr = std::dynamic_pointer_cast<PBRMaterial>(_canvasMaterial);
-    
-    _canvasMtlAccessPtr->setup(
-        "materials/paper/paper001_1K_Color.png",
-        "materials/paper/paper002_1K_Normal.png",
-        "",
-        "materials/paper/paper002_1K_Roughness.png",
-        ""
-    );
-    _canvasMtlAccessPtr->setNormalMapMult(1.0f);
-    _canvasMtlAccessPtr->setMetallic(0.0f);
-
-    // Load node material
-    _nodeMaterial = std::make_shared<PBRMaterial>(ofFloatColor::white, 0.125f, 0.5f, 1.0f);
-    std::shared_ptr<PBRMaterial> _nodeMtlAccessPtr = std::dynamic_pointer_cast<PBRMaterial>(_nodeMaterial);
-
-    _nodeMtlAccessPtr->setup(
-        "",
-        "materials/bevel/Bevel_Normal.png",
-        "",
-        "materials/bevel/Bevel_Roughness.png",
-        ""
-    );
-    _nodeMtlAccessPtr->setNormalMapMult(1.0f);
-    _nodeMtlAccessPtr->setMetallic(0.0f);
-
     // Light
     _light = std::make_shared<ofLight>();
 
@@ -89,7 +62,9 @@ void SimulationManager::init(SimSettings settings)
     //ofColor::fromHex(ofHexToInt());
 
     //  shadows
-    _shadowMap.setup(1024);
+    if (bGraphics) {
+        _shadowMap.setup(1024);
+    }
 
     // preview world
     _previewWorld = new SimWorld();
@@ -102,13 +77,14 @@ void SimulationManager::init(SimSettings settings)
         _settings.canvasSize, _settings.canvasViewSize, _settings.canvasMargin,
         _canvasResolution.x, _canvasResolution.y,
         _canvasConvResolution.x, _canvasConvResolution.y,
-        _previewWorld->getBtWorld()
+        _previewWorld->getBtWorld(), settings.canvasBackend
     );
     _previewCanvas->setMaterial(_canvasMaterial);
     _previewCanvas->setShader(_canvasShader);
     _previewCanvas->setCanvasUpdateShader(_canvasUpdateShader);
     _previewCanvas->setCanvasColorizeShader(_canvasColorShader);
     _previewCanvas->setSubTextureShader(_canvasSubTextureShader);
+    _previewCanvas->setColorizeOnUpdate(!bHeadless);
     _previewCanvas->addToWorld();
 
     // time
@@ -141,14 +117,24 @@ void SimulationManager::init(SimSettings settings)
     _cpgQueue.allocate(32);
 
     // texture
-    if (bStoreLastArtifact) {
+    if (bStoreLastArtifact && bGraphics) {
         _prevArtifactTexture.allocate(_canvasResolution.x, _canvasResolution.y, GL_RGBA);
         _artifactCopyBuffer.allocate(_canvasResolution.x * _canvasResolution.y * 4, GL_DYNAMIC_COPY);
     }
 
     // eval
     _evaluationType = settings.evalType;
-    _evaluationDispatcher.setup(_evaluationType, _canvasResolution.x, _canvasResolution.y);
+    EvaluationDispatcher::EvaluatorSettings evaluatorSettings;
+    evaluatorSettings.maskFile = settings.evalMaskFile;
+    evaluatorSettings.compositeTypes = settings.evalCompositeTypes;
+    evaluatorSettings.compositeWeights = settings.evalCompositeWeights;
+    evaluatorSettings.bWriteToDisk = settings.evalWriteToDisk;
+    evaluatorSettings.domainSearch = settings.evalDomainSearch;
+    evaluatorSettings.searchFallbackError = settings.evalSearchFallbackError;
+    evaluatorSettings.bNativeResolution = settings.evalNativeResolution;
+
+    _evaluationDispatcher.setup(_evaluationType, _canvasResolution.x, _canvasResolution.y, settings.numEvalWorkers, settings.numEvalWorkerThreads, evaluatorSettings);
+    _evaluationDispatcher.setupCache(settings.evalCacheSize, settings.evalCacheEviction);
 
     // test
     //cv::Mat testImage = cv::imread("data/keep/circle.bmp", cv::ImreadModes::IMREAD_GRAYSCALE);
@@ -175,8 +161,17 @@ void SimulationManager::startSimulation()
         _frameTimeAccumulator = 0.0;
         _clock.reset();
 
+        _stepCounter = 0;
+        _stepsPerSecond = 0.0;
+        _awaitCounter = 0;
+        _awaitMicrosAccumulator = 0;
+        _awaitMicrosMaxAccumulator = 0;
+        _awaitMillisAverage = 0.0;
+        _awaitMillisMax = 0.0;
+        _stepRateWindowStart = _clock.getTimeMilliseconds();
+
         // Register network event listeners
-        _networkManager.setup(_settings.host, _settings.inPort, _settings.outPort);
+        _networkManager.setup(_settings.host, _settings.inPort, _settings.outPort, _settings.transport, _settings.shmName, _settings.batchObservations, _settings.asyncIO);
         _connectionEstablishedListener = _networkManager.onConnectionEstablished.newListener([this] {
             setStatus("Connection with evolution module established!");
             uint32_t numJoints = _selectedGenome->getNumJointsUnfolded();
@@ -218,7 +213,9 @@ void SimulationManager::startSimulation()
         uint32_t numJoints = _selectedGenome->getNumJointsUnfolded();
         uint32_t numBrushes = 1; // This is 1 & fixed with regard to the local perception method
 
-        _networkManager.allocate(numJoints, numJoints + numBrushes, _canvasConvResolution.x, _canvasConvResolution.y, OF_PIXELS_GRAY);
+        _networkManager.allocate(numJoints, numJoints + numBrushes, _canvasConvResolution.x, _canvasConvResolution.y, OF_PIXELS_GRAY, _simInstanceLimit);
+        _networkManager.setPatchStream(_settings.patchStream, _settings.patchKeyframeInterval);
+        _networkManager.setObservationFrames(_settings.observationFrames);
         _networkManager.search();
        
         setStatus("Awaiting evolution module input...");
@@ -236,6 +233,16 @@ void SimulationManager::stopSimulation()
         _infoReceivedListener.unsubscribe();
         _pulseReceivedListener.unsubscribe();
         _networkManager.close();
+
+        if (!_settings.latencyCsv.empty()) {
+            std::string path = ofToDataPath(_settings.latencyCsv, true);
+            if (_networkManager.getLatencyMonitor().writeCsv(path)) {
+                ofLog() << "Latency histograms written to " << path;
+            }
+            else {
+                ofLogError() << "Could not write latency histograms to " << path;
+            }
+        }
     }
 }
 
@@ -267,10 +274,38 @@ int SimulationManager::createSimInstance(SimInfo info)
     btScalar zpos = (grid_z - _simInstanceGridSize / 2) * stride + grid_z * _settings.canvasMargin;
     btVector3 position = (bMultiEval) ? btVector3(xpos, 0, zpos) : btVector3(0, 0, 0);
 
+    SimInstance* instance = acquireSimInstance(info, position);
+    _networkManager.beginRollout(instance->getID());
+    _networkManager.sendState(instance);
+    _simulationInstances.push_back(instance);
+
+    setStatus("Running simulation instance [GEN:" + ofToString(info.generation) + "] [ID:" + ofToString(info.candidate_id) + "]");
+    return info.candidate_id;
+}
+
+SimInstance* SimulationManager::acquireSimInstance(const SimInfo& info, btVector3 position)
+{
+    // Pooled instances carry a phenome of the genome they were built from
+    if (_pooledGenome != _selectedGenome) {
+        clearSimInstancePool();
+        _pooledGenome = _selectedGenome;
+        _bodyPlan = std::make_shared<SimBodyPlan>(*_selectedGenome);
+    }
+    if (!_simInstancePool.empty()) {
+        SimInstance* instance = _simInstancePool.back();
+        _simInstancePool.pop_back();
+
+        instance->reset(info.candidate_id, info.generation, info.duration, position);
+        instance->getCreature()->setSensorMode(bCanvasSensors ? SimCreature::Canvas : SimCreature::Touch);
+        instance->getCanvas()->setColorizeOnUpdate(!bHeadless);
+        setupSimInstance(instance);
+        return instance;
+    }
+
     SimWorld* world = new SimWorld();
     world->getTerrainNode()->getRigidBody()->setCollisionFlags(btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT);
 
-    SimCreature* crtr = new SimCreature(position, _selectedGenome, world->getBtWorld());
+    SimCreature* crtr = new SimCreature(position, _bodyPlan, world->getBtWorld());
     crtr->setSensorMode(bCanvasSensors ? SimCreature::Canvas : SimCreature::Touch);
     crtr->setMaterial(_nodeMaterial);
     crtr->setShader(_nodeShader);
@@ -279,26 +314,79 @@ int SimulationManager::createSimInstance(SimInfo info)
     SimCanvasNode* canv = new SimCanvasNode(position, _settings.canvasSize, _settings.canvasViewSize, _settings.canvasMargin,
         _canvasResolution.x, _canvasResolution.y,
         _canvasConvResolution.x, _canvasConvResolution.y, 
-        world->getBtWorld()
+        world->getBtWorld(), _settings.canvasBackend
     );
     canv->setMaterial(_canvasMaterial);
     canv->setShader(_canvasShader);
     canv->setCanvasUpdateShader(_canvasUpdateShader);
     canv->setCanvasColorizeShader(_canvasColorShader);
     canv->setSubTextureShader(_canvasSubTextureShader);
+    canv->setColorizeOnUpdate(!bHeadless);
     canv->spawnBounds(true);
     canv->addToWorld();
 
     SimInstance* instance = new SimInstance(info.candidate_id, info.generation, world, crtr, canv, info.duration);
-    _networkManager.sendState(instance);
-    _simulationInstances.push_back(instance);
+    setupSimInstance(instance);
+    return instance;
+}
 
-    setStatus("Running simulation instance [GEN:" + ofToString(info.generation) + "] [ID:" + ofToString(info.candidate_id) + "]");
-    return info.candidate_id;
+void SimulationManager::setupSimInstance(SimInstance* instance)
+{
+    // Plateaus are detected from the running coverage, which gpu canvases only keep when asked to
+    instance->getCanvas()->setCoverageTracking(_settings.earlyStopPlateauTime > 0.0f);
+    instance->setEarlyTermination(_settings.earlyStopIdleTime, _settings.earlyStopPlateauTime, _settings.earlyStopPlateauGain);
+}
+
+void SimulationManager::queueArtifact(SimInstance* instance)
+{
+    SimCanvasNode* canvas = instance->getCanvas();
+
+    // The cpu canvas coverage is exact, so coverage fitness needs neither the paint map nor an evaluator
+    if (_evaluationType == EvaluationType::Coverage && canvas->getBackend() == SimCanvasNode::CPU) {
+        _evaluationDispatcher.queueResults({ canvas->getCoverage() }, instance->getGeneration(), instance->getID());
+        return;
+    }
+
+    if (canvas->getNumPaintedStrokes() == 0) {
+        // nothing landed on the canvas, skip the readback
+        _artifactMat = cv::Mat::zeros(_canvasResolution.x, _canvasResolution.y, CV_8UC1);
+    }
+    else if (canvas->getBackend() == SimCanvasNode::CPU) {
+        // paint map already lives in memory, copy it as the canvas is released after this
+        _artifactMat = cv::Mat(_canvasResolution.x, _canvasResolution.y, CV_8UC1, (void*)canvas->getPaintMapPixels().getData()).clone();
+    }
+    else {
+        // copy out of the mapped buffer, evaluator workers read the artifact long after it is unmapped
+        _imageSaver.copyToBuffer(canvas->getPaintMap()->getTexture(), [&](uint8_t* p) {
+            _artifactMat = cv::Mat(_canvasResolution.x, _canvasResolution.y, CV_8UC1, p).clone();
+        });
+    }
+    _evaluationDispatcher.queue(_artifactMat, instance->getGeneration(), instance->getID());
+}
+
+void SimulationManager::releaseSimInstance(SimInstance* instance)
+{
+    if (_pooledGenome == _selectedGenome && _simInstancePool.size() < _simInstanceLimit) {
+        _simInstancePool.push_back(instance);
+    }
+    else {
+        delete instance;
+    }
+}
+
+void SimulationManager::clearSimInstancePool()
+{
+    for (SimInstance* instance : _simInstancePool) {
+        delete instance;
+    }
+    _simInstancePool.clear();
 }
 
 void SimulationManager::lateUpdate()
 {
+    if (!bGraphics) {
+        return;
+    }
     if (bMouseLight) {
         float longitude = ofMap(ofGetMouseX(), 0, ofGetWidth(), -PI, PI);
         float latitude = ofMap(ofGetMouseY(), 0, ofGetHeight(), -HALF_PI, HALF_PI*0.25f);
@@ -334,7 +422,11 @@ void SimulationManager::update()
 
     _networkManager.receive();
 
-    if (bSimulationActive) {
+    if (bSimulationActive && bHeadless) {
+        _runTimeMillis = _timeMillis - _startTimeMillis;
+        performHeadlessSteps();
+    }
+    else if (bSimulationActive) {
         _runTimeMillis = _timeMillis - _startTimeMillis;
         _simulationSpeed = simulationSpeed;
 
@@ -360,6 +452,9 @@ void SimulationManager::update()
             _frameTimeAccumulator -= _frameTimeMillis * steps;
         }
     }
+    if (bSimulationActive) {
+        updateStepRate();
+    }
 
     // scope for lock_guard
     {
@@ -377,23 +472,38 @@ void SimulationManager::update()
     for (auto& instance : _simulationInstances) {
         if (instance->isFinished() || instance->isTerminated()) {
 
-            _imageSaver.copyToBuffer(instance->getCanvas()->getPaintMap()->getTexture(), [&](uint8_t* p) {
-                _artifactMat = cv::Mat(_canvasResolution.x, _canvasResolution.y, CV_8UC1, p);
-            });
-            _evaluationDispatcher.queue(_artifactMat, instance->getGeneration(), instance->getID());
+            SimCanvasNode* canvas = instance->getCanvas();
+            bool bCpuCanvas = canvas->getBackend() == SimCanvasNode::CPU;
+
+            if (instance->isStagnant()) {
+                _numEarlyStops++;
+                _earlyStopSavedTime += instance->getDuration() - instance->getElapsedTime();
+                ofLog() << "Rollout " << instance->getGeneration() << ":" << instance->getID() << " stagnated at " <<
+                    ofToString(instance->getElapsedTime(), 1) << "s (coverage: " << ofToString(canvas->getCoverage(), 4) << ")";
+            }
+            queueArtifact(instance);
 
             if (bSaveArtifactsToDisk) {
+                if (bHeadless) {
+                    canvas->updateColorMap();
+                }
                 std::string path = _simDir + '/' + NTRS_ARTIFACTS_PREFIX + ofToString(instance->getGeneration()) + '_' + ofToString(instance->getID());
-                _imageSaver.save(instance->getCanvas()->getPaintMapRGBA()->getTexture(), path);
+                if (bCpuCanvas) {
+                    _imageSaver.save(canvas->getPaintMapRGBAPixels(), path);
+                }
+                else {
+                    _imageSaver.save(canvas->getPaintMapRGBA()->getTexture(), path);
+                }
             }
             _networkManager.send(OSC_END_ROLLOUT + '/' + ofToString(instance->getID()));
+            _networkManager.endRollout(instance->getID());
 
-            if (bStoreLastArtifact) {
-                instance->getCanvas()->getPaintMapRGBA()->getTexture().copyTo(_artifactCopyBuffer);
+            if (bStoreLastArtifact && bGraphics) {
+                canvas->getPaintMapRGBA()->getTexture().copyTo(_artifactCopyBuffer);
                 _prevArtifactTexture.loadData(_artifactCopyBuffer, GL_RGBA, GL_UNSIGNED_BYTE);
             }
 
-            delete instance;
+            releaseSimInstance(instance);
             _simulationInstances.erase(_simulationInstances.begin() + i);
             bInstanceDestroyed = true;
             
@@ -401,6 +511,9 @@ void SimulationManager::update()
         }
     }
 
+    // first observations of the instances created above
+    _networkManager.flushObservations();
+
     // Quick and dirty
     if (bInstanceDestroyed && !bStopSimulationQueued) {
         _networkManager.search();
@@ -427,26 +540,127 @@ void SimulationManager::update()
 }
 
 void SimulationManager::performTrueSteps(btScalar timeStep)
+{
+    // actions that landed since the last step are applied right away instead of on the next frame
+    if (_networkManager.isAsyncIO()) {
+        _networkManager.receive();
+    }
+    if (_jobSystem.getNumThreads() > 1 && _simulationInstances.size() > 1) {
+        // Every instance owns its own world, so physics can be stepped concurrently.
+        // Canvas (GL) and network hand-off stay on the main thread.
+        _instanceStepped.assign(_simulationInstances.size(), 0);
+        _jobSystem.parallelFor(_simulationInstances.size(), [this, timeStep](size_t i) {
+            _instanceStepped[i] = _simulationInstances[i]->updateTimeStep(timeStep);
+        });
+        for (size_t i = 0; i < _simulationInstances.size(); i++) {
+            _stepCounter += _instanceStepped[i];
+            handOffSimInstance(_simulationInstances[i]);
+        }
+    }
+    else {
+        for (auto& instance : _simulationInstances) {
+            updateSimInstance(instance, timeStep);
+        }
+    }
+    // every instance that became ready during this step goes out in one batch
+    _networkManager.flushObservations();
+}
+
+// Steps all instances back-to-back for a fixed wall-clock budget instead of converting frame time into steps.
+// Returns early when every instance is blocked on the controller so that network input is polled again, or with async
+// network I/O, sleeps until the controller replies.
+void SimulationManager::performHeadlessSteps()
+{
+    _timeStepsPerUpdate = 0;
+    btScalar deadline = _clock.getTimeMilliseconds() + _settings.headlessStepBudgetMillis;
+
+    while (isSimulationInstanceActive() && _clock.getTimeMilliseconds() < deadline) {
+        performTrueSteps(FIXED_TIMESTEP);
+        _timeStepsPerUpdate++;
+
+        if (isAwaitingInput() && !waitForInput(deadline)) {
+            break;
+        }
+    }
+}
+
+void SimulationManager::updateStepRate()
+{
+    btScalar window = _timeMillis - _stepRateWindowStart;
+    if (window >= 1000.0) {
+        _stepsPerSecond = _stepCounter * 1000.0 / window;
+        _stepCounter = 0;
+        _stepRateWindowStart = _timeMillis;
+
+        _awaitMillisAverage = (_awaitCounter > 0) ? _awaitMicrosAccumulator / (1000.0 * _awaitCounter) : 0.0;
+        _awaitMillisMax = _awaitMicrosMaxAccumulator / 1000.0;
+        _awaitCounter = 0;
+        _awaitMicrosAccumulator = 0;
+        _awaitMicrosMaxAccumulator = 0;
+
+        if (bHeadless && isSimulationInstanceActive()) {
+            ofLog() << "[Headless] physics steps/s: " << ofToString(_stepsPerSecond, 1) << " (" << _simulationInstances.size() << " instance(s))" <<
+                ", await avg/max: " << ofToString(_awaitMillisAverage, 2) << "/" << ofToString(_awaitMillisMax, 2) << "ms";
+        }
+    }
+}
+
+// True if no instance can make progress without a new message from the controller
+bool SimulationManager::isAwaitingInput()
 {
     for (auto& instance : _simulationInstances) {
-        updateSimInstance(instance, timeStep);
+        if (instance->isFinished() || instance->isTerminated()) {
+            return true;
+        }
+        if (!instance->isEffectorUpdateRequired()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sleeps until a controller message arrives or the deadline passes, true if stepping can continue.
+// Finished instances are closed by update, so there is nothing to wait for then.
+bool SimulationManager::waitForInput(btScalar deadline)
+{
+    if (!_networkManager.isAsyncIO()) {
+        return false;
+    }
+    for (auto& instance : _simulationInstances) {
+        if (instance->isFinished() || instance->isTerminated()) {
+            return false;
+        }
+    }
+    btScalar remaining = deadline - _clock.getTimeMilliseconds();
+    if (remaining <= 0.0 || !_networkManager.waitForMessages(uint32_t(remaining * 1000.0))) {
+        return false;
     }
+    _networkManager.receive();
+    return true;
 }
 
 void SimulationManager::updateSimInstance(SimInstance* instance, double timeStep)
 {
-    instance->updateTimeStep(timeStep);
+    if (instance->updateTimeStep(timeStep)) {
+        _stepCounter++;
+    }
+    handOffSimInstance(instance);
+}
 
+// Applies queued effectors, updates the canvas and sends the next observation. Must run on the main thread.
+void SimulationManager::handOffSimInstance(SimInstance* instance)
+{
     bool bEffectorsQueued = false;
     if (instance->isEffectorUpdateRequired()) {
-        bEffectorsQueued =
-            _networkManager.isAgentOutputQueued() &&
-            _networkManager.getQueuedAgentId() == instance->getID();
+        bEffectorsQueued = _networkManager.isAgentOutputQueued(instance->getID());
 
         if (bEffectorsQueued) {
             // update effectors
-            instance->getCreature()->updateOutputs(_networkManager.popOutputBuffer());
-            instance->updateCreature();
+            instance->updateEffectors(_networkManager.popOutputBuffer(instance->getID()));
+
+            _awaitCounter++;
+            _awaitMicrosAccumulator += instance->getLastAwaitMicros();
+            _awaitMicrosMaxAccumulator = std::max(_awaitMicrosMaxAccumulator, instance->getLastAwaitMicros());
         }
     }
     instance->updateCanvas();
@@ -667,6 +881,36 @@ uint32_t SimulationManager::getTimeStepsPerUpdate()
     return _timeStepsPerUpdate;
 }
 
+uint32_t SimulationManager::getNumSimThreads()
+{
+    return _jobSystem.getNumThreads();
+}
+
+double SimulationManager::getStepsPerSecond()
+{
+    return _stepsPerSecond;
+}
+
+double SimulationManager::getAverageAwaitMillis()
+{
+    return _awaitMillisAverage;
+}
+
+double SimulationManager::getMaxAwaitMillis()
+{
+    return _awaitMillisMax;
+}
+
+uint32_t SimulationManager::getNumEarlyStops()
+{
+    return _numEarlyStops;
+}
+
+double SimulationManager::getEarlyStopSavedTime()
+{
+    return _earlyStopSavedTime;
+}
+
 const std::vector<float> SimulationManager::getCPGBuffer()
 {
     return _cpgQueue.getBuffer();
@@ -677,6 +921,16 @@ EvaluationType SimulationManager::getEvaluationType()
     return _evaluationType;
 }
 
+EvaluationDispatcher& SimulationManager::getEvaluationDispatcher()
+{
+    return _evaluationDispatcher;
+}
+
+NetworkManager& SimulationManager::getNetworkManager()
+{
+    return _networkManager;
+}
+
 bool SimulationManager::loadGenomeFromDisk(std::string filename)
 {
     _selectedGenome = std::make_shared<DirectedGraph>();
@@ -757,6 +1011,50 @@ void SimulationManager::generateRandomGenome()
     }
 }
 
+void SimulationManager::loadMaterials()
+{
+    // Load terrain material
+    _terrainMaterial = std::make_shared<PBRMaterial>(ofFloatColor::white, 0.0625f, 0.125f, 1.0f);
+    std::shared_ptr<PBRMaterial> _terrainMtlAccessPtr = std::dynamic_pointer_cast<PBRMaterial>(_terrainMaterial);
+    _terrainMtlAccessPtr->setup(
+        "materials/wood/WoodFloor024_1K_Color.jpg",
+        "materials/wood/WoodFloor024_1K_Normal.jpg",
+        "",
+        "materials/wood/WoodFloor024_1K_Roughness.jpg",
+        "materials/wood/WoodFloor024_1K_AmbientOcclusion.jpg"
+    );
+    _terrainMtlAccessPtr->setNormalMapMult(0.5f);
+    _terrainMtlAccessPtr->setMetallic(0.0f);
+
+    // Load canvas material
+    _canvasMaterial = std::make_shared<PBRMaterial>(ofFloatColor::white, 0.125f, 0.75f, 1.0f);
+    std::shared_ptr<PBRMaterial> _canvasMtlAccessPtr = std::dynamic_pointer_cast<PBRMaterial>(_canvasMaterial);
+    
+    _canvasMtlAccessPtr->setup(
+        "materials/paper/paper001_1K_Color.png",
+        "materials/paper/paper002_1K_Normal.png",
+        "",
+        "materials/paper/paper002_1K_Roughness.png",
+        ""
+    );
+    _canvasMtlAccessPtr->setNormalMapMult(1.0f);
+    _canvasMtlAccessPtr->setMetallic(0.0f);
+
+    // Load node material
+    _nodeMaterial = std::make_shared<PBRMaterial>(ofFloatColor::white, 0.125f, 0.5f, 1.0f);
+    std::shared_ptr<PBRMaterial> _nodeMtlAccessPtr = std::dynamic_pointer_cast<PBRMaterial>(_nodeMaterial);
+
+    _nodeMtlAccessPtr->setup(
+        "",
+        "materials/bevel/Bevel_Normal.png",
+        "",
+        "materials/bevel/Bevel_Roughness.png",
+        ""
+    );
+    _nodeMtlAccessPtr->setNormalMapMult(1.0f);
+    _nodeMtlAccessPtr->setMetallic(0.0f);
+}
+
 void SimulationManager::loadShaders()
 {
     _terrainShader = std::make_shared<ofShader>();
@@ -796,12 +1094,19 @@ bool SimulationManager::isSimulationInstanceActive()
     return !_simulationInstances.empty();
 }
 
+bool SimulationManager::isHeadless()
+{
+    return bHeadless;
+}
+
 void SimulationManager::dealloc()
 {
+    _jobSystem.stop();
     delete _previewWorld;
 
     for (auto &instance : _simulationInstances) {
         delete instance;
     }
+    clearSimInstancePool();
     _networkManager.close();
 }
@@ -15,6 +15,7 @@
 #include "Utils/ImageSaverThread.h"
 #include "Utils/ImageSaver.h"
 #include "Utils/FixedQueue.h"
+#include "Utils/JobSystem.h"
 #include "Networking/BufferSender.h"
 #include "Networking/NetworkManager.h"
 #include "ofMain.h"
@@ -29,18 +30,82 @@ public:
     struct SimSettings
     {
         EvaluationType evalType = EvaluationType::Coverage;
+
+        // Target image of MaskCoverage evaluation, relative to the data folder
+        std::string evalMaskFile = "";
+
+        // Objectives of Composite evaluation and their weights in the combined fitness (missing weights are 1)
+        std::vector<EvaluationType> evalCompositeTypes = { EvaluationType::Coverage, EvaluationType::OrderlyCoverage };
+        std::vector<double> evalCompositeWeights;
+
+        // Intermediate images of Aesthetics and OrderlyCoverage evaluations in data/keep/ (first evaluator worker only)
+        bool evalWriteToDisk = false;
+
+        // Fractal encode of Aesthetics evaluation (see EvaluationDispatcher::EvaluatorSettings)
+        FractalCompressor::DomainSearch evalDomainSearch = FractalCompressor::SEARCH_EXHAUSTIVE;
+        float evalSearchFallbackError = 6.0f;
+        bool evalNativeResolution = false;
+
         uint32_t canvasResolution = 128;
         uint32_t canvasConvResolution = 64;
 
+        // Canvas paint backend, CPU runs without a GL context
+        SimCanvasNode::Backend canvasBackend = SimCanvasNode::GPU;
+
         float canvasSize = 4.0f;
         float canvasViewSize = 1.0f;
         float canvasMargin = 4.0f;
 
         uint32_t maxParallelSims = 1;
+
+        // Number of threads used to step simulation instances (0: hardware concurrency, 1: main thread only)
+        uint32_t numSimThreads = 0;
+
+        // Number of artifact evaluator workers (0: hardware concurrency)
+        uint32_t numEvalWorkers = 1;
+
+        // Threads each evaluator worker may use for a single evaluation (0: hardware concurrency / workers)
+        uint32_t numEvalWorkerThreads = 1;
+
+        // Cached evaluation results by artifact content (0: no cache)
+        size_t evalCacheSize = 0;
+        FitnessCache::Eviction evalCacheEviction = FitnessCache::LRU;
+
+        // Rollouts that have not painted after earlyStopIdleTime seconds, or whose coverage grew less than
+        // earlyStopPlateauGain during the last earlyStopPlateauTime seconds, end early (0: disabled)
+        float earlyStopIdleTime = 0.0f;
+        float earlyStopPlateauTime = 0.0f;
+        float earlyStopPlateauGain = 0.001f;
+
+        // Headless mode steps physics in a tight loop decoupled from the frame clock
+        bool headless = false;
+        float headlessStepBudgetMillis = 16.0f;
+
         std::string genomeFile = "";
         std::string host = "localhost";
         int inPort = 1024;
         int outPort = 1025;
+
+        // Observation/action transport, shm requires the controller to run on the same machine
+        NetworkManager::Transport transport = NetworkManager::OSC;
+        std::string shmName = "neatures";
+
+        // Sends the OSC observations of a tick as one compressed batch instead of a message and image per instance
+        bool batchObservations = false;
+
+        // Compresses OSC conv patches against the previous patch of an instance, a keyframe every interval patches
+        bool patchStream = false;
+        uint32_t patchKeyframeInterval = 30;
+
+        // Receives OSC messages and sends joint states on an I/O thread, so a controller reply is picked up between
+        // physics steps instead of once per frame
+        bool asyncIO = false;
+
+        // Sends each OSC observation as a single binary frame datagram on /frm instead of /jnts and /art/ messages
+        bool observationFrames = false;
+
+        // Writes the control loop latency histograms to this file (data path) when the simulation stops, empty: never
+        std::string latencyCsv;
     };
 
     void init(SimSettings settings);
@@ -63,10 +128,12 @@ public:
     void terminateSimInstances();
 
     void loadShaders();
+    void loadMaterials();
 
     bool isInitialized();
     bool isSimulationActive();
     bool isSimulationInstanceActive();
+    bool isHeadless();
 
     ofEasyCam* getCamera();
     ofTexture* getPrevArtifactTexture();
@@ -81,9 +148,19 @@ public:
     glm::ivec2 getCanvasResolution();
     glm::ivec2 getCanvasConvResolution();
     uint32_t getTimeStepsPerUpdate();
+    uint32_t getNumSimThreads();
+    double getStepsPerSecond();
+    double getAverageAwaitMillis();
+    double getMaxAwaitMillis();
+
+    // Rollouts that stagnated and ended before their duration, and the simulated time this saved (s)
+    uint32_t getNumEarlyStops();
+    double getEarlyStopSavedTime();
     const std::vector<float> getCPGBuffer();
 
     EvaluationType getEvaluationType();
+    EvaluationDispatcher& getEvaluationDispatcher();
+    NetworkManager& getNetworkManager();
 
     bool loadGenomeFromDisk(std::string filename);
     void generateRandomGenome();
@@ -115,9 +192,19 @@ private:
     void setStatus(std::string msg);
 
     int createSimInstance(SimInfo info);
+    SimInstance* acquireSimInstance(const SimInfo& info, btVector3 position);
+    void setupSimInstance(SimInstance* instance);
+    void queueArtifact(SimInstance* instance);
+    void releaseSimInstance(SimInstance* instance);
+    void clearSimInstancePool();
     void updateSimInstance(SimInstance* instance, double timeStep);
+    void handOffSimInstance(SimInstance* instance);
 
     void performTrueSteps(btScalar timeStep);
+    void performHeadlessSteps();
+    void updateStepRate();
+    bool isAwaitingInput();
+    bool waitForInput(btScalar deadline);
 
     SimSettings _settings;
     EvaluationType _evaluationType;
@@ -127,6 +214,17 @@ private:
     std::vector<SimInstance*> _simulationInstances;
     std::mutex _cbQueueMutex;
 
+    // finished instances are reset and reused as long as the selected genome doesn't change
+    std::vector<SimInstance*> _simInstancePool;
+    std::shared_ptr<DirectedGraph> _pooledGenome;
+
+    // body plan of the pooled genome, shared by every creature that is spawned from it
+    std::shared_ptr<const SimBodyPlan> _bodyPlan;
+
+    // steps the physics worlds of independent instances concurrently
+    JobSystem _jobSystem;
+    std::vector<char> _instanceStepped;
+
     std::string _status = "";
     std::string _uniqueSimId = "_NA";
     std::string _simDir = NTRS_SIMS_DIR;
@@ -153,6 +251,22 @@ private:
     btScalar _frameTimeMillis = 0;
     btScalar _frameTimeAccumulator = 0;
 
+    // physics throughput
+    uint64_t _stepCounter = 0;          // instance steps taken since _stepRateWindowStart
+    btScalar _stepRateWindowStart = 0;
+    double _stepsPerSecond = 0.0;
+
+    // time instances spend waiting for effectors, over the same window
+    uint64_t _awaitCounter = 0;
+    uint64_t _awaitMicrosAccumulator = 0;
+    uint64_t _awaitMicrosMaxAccumulator = 0;
+    double _awaitMillisAverage = 0.0;
+    double _awaitMillisMax = 0.0;
+
+    // rollouts that ended early
+    uint32_t _numEarlyStops = 0;
+    double _earlyStopSavedTime = 0.0;
+
     // graphics
     std::shared_ptr<ofShader> _terrainShader;
     std::shared_ptr<ofShader> _nodeShader;
@@ -169,6 +283,8 @@ private:
     float _lightDistanceFromFocus = 32.0f;
 
     bool bInitialized = false;
+    bool bHeadless = false;
+    bool bGraphics = true;
     bool bHasSimulationId = false;
     bool bSimulationActive = false;
     bool bStopSimulationQueued = false;
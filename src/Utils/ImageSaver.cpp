@@ -6,9 +6,6 @@ void ImageSaver::setup(int width, int height)
     _width = width;
     _height = height;
 
-    for (int i = 0; i < 2; i++) {
-        _pixelWriteBuffers[i].allocate(_width*_height*4, GL_DYNAMIC_READ);
-    }
     int iPBO = 0;
     _pboPtr = &_pixelWriteBuffers[iPBO];
 }
@@ -27,6 +24,7 @@ void ImageSaver::save(const ofTexture& texture, std::string path)
 
 void ImageSaver::copyToBuffer(const ofTexture& texture, std::function<void(uint8_t* ptr)> copyFunc)
 {
+    allocateReadBuffer();
     texture.copyTo(*_pboPtr);
     _pboPtr->bind(GL_PIXEL_UNPACK_BUFFER);
 
@@ -40,6 +38,7 @@ void ImageSaver::copyToBuffer(const ofTexture& texture, std::function<void(uint8
 
 void ImageSaver::writeToPixels(const ofTexture& texture)
 {
+    allocateReadBuffer();
     texture.copyTo(*_pboPtr);
 
     _pboPtr->bind(GL_PIXEL_UNPACK_BUFFER);
@@ -52,6 +51,14 @@ void ImageSaver::writeToPixels(const ofTexture& texture)
     swapBuffers();
 }
 
+void ImageSaver::allocateReadBuffer()
+{
+    // Allocated on first texture readback so pixel-only saving works without a GL context
+    if (!_pboPtr->isAllocated()) {
+        _pboPtr->allocate(_width*_height*4, GL_DYNAMIC_READ);
+    }
+}
+
 void ImageSaver::swapBuffers()
 {
     _iPBO = (_iPBO + 1) % 2;
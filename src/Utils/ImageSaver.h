@@ -15,6 +15,7 @@ public:
 
 private:
 	void writeToPixels(const ofTexture& tex);
+	void allocateReadBuffer();
 	void swapBuffers();
 
 	ImageSaverThread _imageSaverThread;
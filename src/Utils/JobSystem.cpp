@@ -0,0 +1,134 @@
+#include "JobSystem.h"
+
+void JobSystem::setup(uint32_t numThreads)
+{
+	stop();
+
+	if (numThreads == 0) {
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	_numThreads = numThreads;
+
+	_queues.clear();
+	for (uint32_t i = 0; i < _numThreads; i++) {
+		_queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	_bRunning = true;
+	for (uint32_t i = 1; i < _numThreads; i++) {
+		_threads.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(_mutex);
+		_bRunning = false;
+	}
+	_wakeCondition.notify_all();
+
+	for (std::thread& t : _threads) {
+		t.join();
+	}
+	_threads.clear();
+}
+
+void JobSystem::parallelFor(size_t count, const job_t& job)
+{
+	if (count == 0) {
+		return;
+	}
+	if (_threads.empty()) {
+		for (size_t i = 0; i < count; i++) {
+			job(i);
+		}
+		return;
+	}
+
+	// the job must be visible before any index can be popped
+	_job = &job;
+	_pending = count;
+
+	for (size_t i = 0; i < count; i++) {
+		WorkQueue& q = *_queues[i % _numThreads];
+		std::lock_guard<std::mutex> guard(q.mutex);
+		q.indices.push_back(i);
+	}
+	{
+		std::lock_guard<std::mutex> guard(_mutex);
+		_generation++;
+	}
+	_wakeCondition.notify_all();
+
+	runJobs(0);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneCondition.wait(lock, [this] { return _pending == 0; });
+	_job = nullptr;
+}
+
+void JobSystem::workerLoop(uint32_t workerIndex)
+{
+	uint64_t seenGeneration = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wakeCondition.wait(lock, [&] { return !_bRunning || _generation != seenGeneration; });
+			if (!_bRunning) {
+				return;
+			}
+			seenGeneration = _generation;
+		}
+		runJobs(workerIndex);
+	}
+}
+
+void JobSystem::runJobs(uint32_t workerIndex)
+{
+	size_t index;
+	while (popOrSteal(workerIndex, index)) {
+		(*_job)(index);
+
+		if (--_pending == 0) {
+			std::lock_guard<std::mutex> guard(_mutex);
+			_doneCondition.notify_all();
+		}
+	}
+}
+
+bool JobSystem::popOrSteal(uint32_t workerIndex, size_t& index)
+{
+	// own work first, from the front
+	{
+		WorkQueue& q = *_queues[workerIndex];
+		std::lock_guard<std::mutex> guard(q.mutex);
+		if (!q.indices.empty()) {
+			index = q.indices.front();
+			q.indices.pop_front();
+			return true;
+		}
+	}
+	// then steal from the back of the other queues
+	for (uint32_t i = 1; i < _numThreads; i++) {
+		WorkQueue& q = *_queues[(workerIndex + i) % _numThreads];
+		std::lock_guard<std::mutex> guard(q.mutex);
+		if (!q.indices.empty()) {
+			index = q.indices.back();
+			q.indices.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t JobSystem::getNumThreads() const
+{
+	return _numThreads;
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
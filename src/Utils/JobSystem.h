@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads that runs index-based jobs in parallel.
+// Every worker owns a queue of indices; a worker that runs out of work steals from the back of another worker's queue,
+// so long-running jobs don't hold up the indices that were assigned to the same worker.
+class JobSystem
+{
+public:
+	typedef std::function<void(size_t)> job_t;
+
+	~JobSystem();
+
+	// numThreads includes the calling thread. 0 uses the number of hardware threads.
+	void setup(uint32_t numThreads);
+	void stop();
+
+	// Runs job(i) for every i in [0, count) and blocks until all of them have finished.
+	// The calling thread participates as worker 0.
+	void parallelFor(size_t count, const job_t& job);
+
+	uint32_t getNumThreads() const;
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<size_t> indices;
+	};
+
+	void workerLoop(uint32_t workerIndex);
+	void runJobs(uint32_t workerIndex);
+	bool popOrSteal(uint32_t workerIndex, size_t& index);
+
+	std::vector<std::thread> _threads;
+	std::vector<std::unique_ptr<WorkQueue>> _queues;
+
+	const job_t* _job = nullptr;
+	std::atomic<size_t> _pending{ 0 };
+
+	std::mutex _mutex;
+	std::condition_variable _wakeCondition;
+	std::condition_variable _doneCondition;
+
+	uint64_t _generation = 0;
+	uint32_t _numThreads = 1;
+	bool _bRunning = false;
+};
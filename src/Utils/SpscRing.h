@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lock-free ring of fixed-size records for exactly one producer and one consumer thread.
+// The producer fills the record returned by beginPush and publishes it with commitPush, the consumer reads front and
+// releases it with pop. Records are raw bytes so their size can be chosen at runtime (e.g. by the number of joints).
+class SpscRing
+{
+public:
+	// Not thread-safe, call before either side starts. capacity is rounded up to a power of two
+	void allocate(uint32_t capacity, size_t recordSize) {
+		uint32_t cap = 1;
+		while (cap < capacity) {
+			cap <<= 1;
+		}
+		_mask = cap - 1;
+		_stride = (recordSize + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+		_data.assign(size_t(cap) * _stride / sizeof(uint64_t), 0);
+		_head.store(0, std::memory_order_relaxed);
+		_tail.store(0, std::memory_order_relaxed);
+	}
+
+	// Producer: the next free record or nullptr if the ring is full
+	uint8_t* beginPush() {
+		uint32_t head = _head.load(std::memory_order_relaxed);
+		if (head - _tail.load(std::memory_order_acquire) > _mask) {
+			return nullptr;
+		}
+		return record(head);
+	}
+
+	void commitPush() {
+		_head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer: the oldest record or nullptr if the ring is empty
+	const uint8_t* front() {
+		uint32_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _head.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return record(tail);
+	}
+
+	void pop() {
+		_tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Either side, may be outdated by the time it returns
+	bool empty() const {
+		return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+	}
+
+	size_t getRecordSize() const {
+		return _stride;
+	}
+
+private:
+	uint8_t* record(uint32_t index) {
+		return reinterpret_cast<uint8_t*>(_data.data()) + size_t(index & _mask) * _stride;
+	}
+
+	// uint64_t keeps every record 8-byte aligned
+	std::vector<uint64_t> _data;
+	size_t _stride = 0;
+	uint32_t _mask = 0;
+
+	// Each index is written by one side only, kept on separate cache lines so they do not bounce between cores
+	alignas(64) std::atomic<uint32_t> _head{ 0 };
+	alignas(64) std::atomic<uint32_t> _tail{ 0 };
+};
@@ -1,12 +1,46 @@
 #include "ofMain.h"
 #include "ofApp.h"
 #include "ofAppGLFWWindow.h"
+#include "ofAppNoWindow.h"
+#include "ofxIniSettings.h"
+#include "Networking/SharedMemoryController.h"
+#include "Networking/OscController.h"
+#include "Artifact/FractalCompressor/FractalBenchmark.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Stand-in controller process for the shared memory transport, no window or simulation
+	if (argc > 1 && std::string(argv[1]) == "--shm-controller") {
+		return SharedMemoryController().run();
+	}
+	// Stand-in controller process for the osc transport, to benchmark the control loop without the evolution module
+	if (argc > 1 && std::string(argv[1]) == "--osc-controller") {
+		return OscController().run();
+	}
+	// Block matching microbenchmark, optionally on an image from disk
+	if (argc > 1 && std::string(argv[1]) == "--fractal-bench") {
+		return FractalBenchmark().run(argc > 2 ? argv[2] : "", argc > 3 ? std::stoi(argv[3]) : 3);
+	}
+
+	ofxIniSettings ini("settings.ini");
+	bool bHeadless = ini.get("mode.headless", false);
+	bool bCpuCanvas = ini.get("canvas.backend", "gpu").compare("cpu") == 0;
+
+	// Headless with a cpu canvas needs no GPU at all, so run without a window or GL context
+	if (bHeadless && bCpuCanvas) {
+		ofInit();
+		auto window = std::make_shared<ofAppNoWindow>();
+		ofGetMainLoop()->addWindow(window);
+		ofRunApp(window, std::make_shared<ofApp>());
+		return ofRunMainLoop();
+	}
+
 	ofGLFWWindowSettings settings;
 	settings.setGLVersion(4, 5);
 	settings.setSize(1280, 720);
+
+	// Headless mode with the gpu canvas still needs a GL context for the canvas buffers, so the window is created but never shown
+	settings.visible = !bHeadless;
 	ofCreateWindow(settings);
 
 	return ofRunApp(std::make_shared<ofApp>());
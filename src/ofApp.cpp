@@ -19,8 +19,13 @@ void ofApp::setup()
 	ofSetWindowPosition(32, 128);
 	ofNoFill();
 
+	// No GL renderer when running windowless with a cpu canvas
+	bGraphics = ofGetGLRenderer() != nullptr;
+
 	ofSetLogLevel("ofThread", OF_LOG_VERBOSE);
-	ofEnableGLDebugLog();
+	if (bGraphics) {
+		ofEnableGLDebugLog();
+	}
 	ofLogToConsole();
 	//ofLog() << "Num threads: " << std::thread::hardware_concurrency();
 
@@ -32,10 +37,17 @@ void ofApp::setup()
 	ofSeedRandom(seed);
 
 	settings = ofxIniSettings("settings.ini");
-	bDraw = settings.get("mode.draw", true);
+	bHeadless = settings.get("mode.headless", false);
+	bDraw = settings.get("mode.draw", true) && !bHeadless;
 	bMonitor = settings.get("mode.monitor", true);
 	bMetaOverlay = settings.get("mode.meta", false);
-	bFullScreen = settings.get("mode.fullscreen", false);
+	bFullScreen = settings.get("mode.fullscreen", false) && !bHeadless;
+
+	// Headless mode never draws so there is no reason to wait for the next frame
+	if (bHeadless) {
+		bLockFrameRate = false;
+		ofSetFrameRate(0);
+	}
 
 	HWND hwnd = GetConsoleWindow();
 	MoveWindow(
@@ -49,6 +61,14 @@ void ofApp::setup()
 	renderRect = ofRectangle(0, 0, renderWidth, renderHeight);
 	renderRectFlipped = ofRectangle(0, renderHeight, renderWidth, -renderHeight);
 
+	if (bGraphics) {
+		setupRenderTargets(renderWidth, renderHeight);
+	}
+	initSim();
+}
+
+void ofApp::setupRenderTargets(int renderWidth, int renderHeight)
+{
 	frameFboSettings.width = renderWidth;
 	frameFboSettings.height = renderHeight;
 	frameFboSettings.internalformat = GL_RGBA;
@@ -70,8 +90,6 @@ void ofApp::setup()
 	recorder.setAdditionalOutputArguments(inputArgs);
 
 	gui.setup();
-
-	initSim();
 }
 
 void ofApp::initSim() 
@@ -86,18 +104,59 @@ void ofApp::initSim()
 
 		SimulationManager::SimSettings simSettings;
 		simSettings.evalType = evalType(settings.get("eval.type", "Coverage"));
+		simSettings.evalMaskFile = settings.get("eval.mask", "");
+
+		std::string compositeTypes = settings.get("eval.composite", "");
+		if (!compositeTypes.empty()) {
+			simSettings.evalCompositeTypes.clear();
+			for (const std::string& type : ofSplitString(compositeTypes, ",", true, true)) {
+				simSettings.evalCompositeTypes.push_back(evalType(type));
+			}
+		}
+		for (const std::string& weight : ofSplitString(settings.get("eval.composite_weights", ""), ",", true, true)) {
+			simSettings.evalCompositeWeights.push_back(ofToDouble(weight));
+		}
+
 		simSettings.canvasSize = settings.get("canvas.size", 4.0f);
 		simSettings.canvasResolution = settings.get("canvas.resolution", 256);
 		simSettings.canvasConvResolution = settings.get("canvas.resolution_conv", 64);
 		simSettings.canvasViewSize = settings.get("canvas.viewsize", 1.0f);
 		simSettings.canvasMargin = settings.get("canvas.margin", 4.0f);
+		simSettings.canvasBackend = settings.get("canvas.backend", "gpu").compare("cpu") == 0 ? SimCanvasNode::CPU : SimCanvasNode::GPU;
 		simSettings.maxParallelSims = settings.get("evolution.max_parallel_sims", 1);
+		simSettings.numSimThreads = settings.get("evolution.sim_threads", 0);
+		simSettings.numEvalWorkers = settings.get("eval.workers", 1);
+		simSettings.numEvalWorkerThreads = settings.get("eval.worker_threads", 1);
+		simSettings.evalCacheSize = settings.get("eval.cache_size", 0);
+		simSettings.evalCacheEviction = FitnessCache::evictionFromString(settings.get("eval.cache_eviction", "lru"));
+		simSettings.evalWriteToDisk = settings.get("eval.write_to_disk", false);
+		simSettings.evalDomainSearch = settings.get("eval.domain_search", "exhaustive").compare("classified") == 0 ? FractalCompressor::SEARCH_CLASSIFIED : FractalCompressor::SEARCH_EXHAUSTIVE;
+		simSettings.evalSearchFallbackError = settings.get("eval.search_fallback_error", 6.0f);
+		simSettings.evalNativeResolution = settings.get("eval.native_resolution", false);
+		simSettings.earlyStopIdleTime = settings.get("evolution.early_stop_idle", 0.0f);
+		simSettings.earlyStopPlateauTime = settings.get("evolution.early_stop_plateau", 0.0f);
+		simSettings.earlyStopPlateauGain = settings.get("evolution.early_stop_plateau_gain", 0.001f);
+		simSettings.headless = bHeadless;
+		simSettings.headlessStepBudgetMillis = settings.get("mode.headless_step_budget", 16.0f);
 		simSettings.genomeFile = settings.get("genome.id", "0");
 		simSettings.host = settings.get("controller.host", "localhost");
 		simSettings.outPort = settings.get("controller.port", 1024);
 		simSettings.inPort = settings.get("controller.port_in", 1025);
+		simSettings.transport = settings.get("controller.transport", "osc").compare("shm") == 0 ? NetworkManager::SHM : NetworkManager::OSC;
+		simSettings.shmName = settings.get("controller.shm_name", "neatures");
+		simSettings.batchObservations = settings.get("controller.batch", false);
+		simSettings.patchStream = settings.get("controller.patch_stream", false);
+		simSettings.patchKeyframeInterval = settings.get("controller.keyframe_interval", 30);
+		simSettings.asyncIO = settings.get("controller.async_io", false);
+		simSettings.observationFrames = settings.get("controller.frames", false);
+		simSettings.latencyCsv = settings.get("controller.latency_csv", "");
 
 		simulationManager.init(simSettings);
+
+		// There is no user input in headless mode, so start listening for the evolution module right away
+		if (bHeadless) {
+			start();
+		}
 	}
 }
 
@@ -338,6 +397,14 @@ void ofApp::imGui()
 				ImGui::Text("fps: %.02f", ofGetFrameRate());
 				if (simulationManager.isInitialized()) {
 					ImGui::Text("timesteps: %d", simulationManager.getTimeStepsPerUpdate());
+					ImGui::Text("steps/s: %.0f", simulationManager.getStepsPerSecond());
+					ImGui::Text("await: %.02fms (max %.02fms)", simulationManager.getAverageAwaitMillis(), simulationManager.getMaxAwaitMillis());
+					ImGui::Text("threads: %d", simulationManager.getNumSimThreads());
+					if (simulationManager.getNetworkManager().getTransport() == NetworkManager::OSC) {
+						const BufferSender& sender = simulationManager.getNetworkManager().getBufferSender();
+						ImGui::Text("patches: %.2fx; %.1fus (%d key, %d delta)", sender.getCompressionRatio(), sender.getAverageEncodeMicros(), (int)sender.getNumKeyframes(), (int)sender.getNumDeltaFrames());
+					}
+					ImGui::Text("early stops: %d (%.0fs saved)", simulationManager.getNumEarlyStops(), simulationManager.getEarlyStopSavedTime());
 				}
 				ImGui::Text("dbgdraw: %s", simulationManager.bDebugDraw ? "on" : "off");
 				ImGui::Dummy(margin);
@@ -355,6 +422,15 @@ void ofApp::imGui()
 				ImGui::Text("Eval");
 				ImGui::Separator();
 				ImGui::Text("func: %s", evalTypeStr(simulationManager.getEvaluationType()).c_str());
+				ImGui::Text("workers: %d", simulationManager.getEvaluationDispatcher().getNumWorkers());
+				ImGui::Text("in flight: %d", simulationManager.getEvaluationDispatcher().getNumInFlight());
+
+				const FitnessCache& cache = simulationManager.getEvaluationDispatcher().getFitnessCache();
+				if (cache.isEnabled()) {
+					ImGui::Text("cache: %d/%d (%s)", (int)cache.getSize(), (int)cache.getCapacity(), FitnessCache::evictionToString(cache.getEviction()).c_str());
+					ImGui::Text("hits: %d; misses: %d (%.1f%%)", (int)cache.getNumHits(), (int)cache.getNumMisses(), cache.getHitRate() * 100.0);
+					ImGui::Text("merged: %d; evicted: %d", (int)simulationManager.getEvaluationDispatcher().getNumMerged(), (int)cache.getNumEvictions());
+				}
 				if (simulationManager.bStoreLastArtifact && simulationManager.getPrevArtifactTexture() != nullptr) {
 					ImGui::Image(
 						(void*)(intptr_t)simulationManager.getPrevArtifactTexture()->getTextureData().textureID,
@@ -385,6 +461,32 @@ void ofApp::imGui()
 					ImGui::Text("Simulation Speed:");
 					ImGui::SliderInt("##SimSpeed", (int*)&simulationManager.simulationSpeed, 0, 32);
 					ImGui::Separator();
+
+					const LatencyMonitor& latency = simulationManager.getNetworkManager().getLatencyMonitor();
+					ImGui::Text("Control Latency:");
+					for (int m = 0; m < LatencyMonitor::NUM_METRICS; m++) {
+						const LatencyHistogram& hist = latency.getTotal(LatencyMonitor::Metric(m));
+						const std::vector<float> values = hist.getPlotValues();
+						ImGui::Text("%s: %.2fms (p99 %.2fms)", LatencyMonitor::metricToString(LatencyMonitor::Metric(m)).c_str(), hist.getPercentileMicros(0.5) / 1000.0, hist.getPercentileMicros(0.99) / 1000.0);
+						ImGui::PlotHistogram(("##Latency" + ofToString(m)).c_str(), &values[0], values.size(), 0, NULL, 0, FLT_MAX, ImVec2(windowSize.x-margin.x, windowSize.x/6));
+					}
+					if (ImGui::TreeNode("Agents (p50/p99 ms)")) {
+						for (const auto& agent : latency.getAgents()) {
+							const LatencyHistogram& obs = agent.second.histograms[LatencyMonitor::OBSERVATION_TO_ACTION];
+							const LatencyHistogram& act = agent.second.histograms[LatencyMonitor::ACTION_TO_OBSERVATION];
+							ImGui::Text("%d: %.2f/%.2f; %.2f/%.2f", agent.first,
+								obs.getPercentileMicros(0.5) / 1000.0, obs.getPercentileMicros(0.99) / 1000.0,
+								act.getPercentileMicros(0.5) / 1000.0, act.getPercentileMicros(0.99) / 1000.0);
+						}
+						ImGui::TreePop();
+					}
+					if (ImGui::Button("Write Latency CSV")) {
+						std::string path = ofToDataPath("latency_" + ofGetTimestampString() + ".csv", true);
+						if (latency.writeCsv(path)) {
+							ofLog() << "Latency histograms written to " << path;
+						}
+					}
+					ImGui::Separator();
 					if (simulationManager.isSimulationInstanceActive()) {
 						ImGui::Text("Elapsed time:");
 						ImGui::Text(simulationManager.getFocusInfo().c_str());
@@ -430,7 +532,7 @@ void ofApp::windowResized(int w, int h)
 	windowRect = ofRectangle(0, 0, w, h);
 	previewRect = ofRectangle(w*0.75f, h*0.75f, w*0.2f, h*0.2f);
 
-	if (bwindowRenderResolution && !recorder.isRecording()) {
+	if (bGraphics && bwindowRenderResolution && !recorder.isRecording()) {
 		frameFboSettings.width = windowRect.width;
 		frameFboSettings.height = windowRect.height;
 		frameFbo.allocate(frameFboSettings);
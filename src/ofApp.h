@@ -19,6 +19,7 @@ public:
 	void imGui();
 
 	void initSim();
+	void setupRenderTargets(int renderWidth, int renderHeight);
 	void start();
 	void stop();
 
@@ -59,6 +60,8 @@ private:
 	bool bEvolve = true;
 	bool bSimulate = true;
 	bool bDraw = true;
+	bool bHeadless = false;
+	bool bGraphics = true;
 	bool bShadows = true;
 	bool bGui = true;
 	bool bFullScreen = true;
@@ -77,8 +80,10 @@ private:
 		if (evalType == EvaluationType::Coverage) return "Coverage";
 		if (evalType == EvaluationType::CircleCoverage) return "CircleCoverage";
 		if (evalType == EvaluationType::InverseCircleCoverage) return "InverseCircleCoverage";
+		if (evalType == EvaluationType::MaskCoverage) return "MaskCoverage";
 		if (evalType == EvaluationType::OrderlyCoverage) return "OrderlyCoverage";
 		if (evalType == EvaluationType::Aesthetics) return "Aesthetics";
+		if (evalType == EvaluationType::Composite) return "Composite";
 		else return "NA";
 	}
 
@@ -87,8 +92,10 @@ private:
 		if (evalTypeStr == "Coverage") return EvaluationType::Coverage;
 		else if (evalTypeStr == "CircleCoverage") return EvaluationType::CircleCoverage;
 		else if (evalTypeStr == "InverseCircleCoverage") return EvaluationType::InverseCircleCoverage;
+		else if (evalTypeStr == "MaskCoverage") return EvaluationType::MaskCoverage;
 		else if (evalTypeStr == "OrderlyCoverage") return EvaluationType::OrderlyCoverage;
 		else if (evalTypeStr == "Aesthetics") return EvaluationType::Aesthetics;
+		else if (evalTypeStr == "Composite") return EvaluationType::Composite;
 		else return EvaluationType::Coverage;
 	}
 